@@ -0,0 +1,210 @@
+// Content-addressed build cache.
+// ──────────────────────────────
+// An opt-in cache directory, keyed by a hash of the source bytes and the options that affect the outputs.
+// Each entry is a single file "<Key>.cas" holding the output files of one run (.bin/.com, .z80, .hex, for each variant) and its listing.
+// A hit restores the outputs and replays the listing without running the tokenizer or the encoder.
+//
+// The directory also holds an index, "CasZ80.idx", with the hit/miss counters and, for each entry, its size and last use.
+// Each run loads the index again just before it writes it back, and only adds its own use to it, so that the runs sharing the cache keep each other's counts and entries;
+// without a lock, a run that writes the index between that load and the write still loses its use.
+// After every run, hit or miss, the least recently used entries are removed until the rest fit into the size bound.
+// Only ANSI C file functions are used: the directory has to exist already.
+#include "Cas.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits.h>
+
+// An entry in the cache index.
+struct CacheEntry {
+   uint64_t Key;	// The hash of the source and options.
+   uint32_t Size;	// The size of the entry file in bytes.
+   uint32_t Stamp;	// The last use, as a tick of the cache clock.
+};
+
+static const char *CacheDir = nullptr;		// The cache directory, or nullptr if not caching.
+static unsigned long CacheMax;			// The size bound for all the entries together in bytes.
+static CacheEntry *Entries; static unsigned EntryN, EntryMax;
+static unsigned long Hits, Misses, Tick;	// The statistics and the cache clock.
+
+// The use of an entry by a run, as added to the index.
+enum CacheUse { UseHit, UseMiss, UsePut };
+
+// The signature of an entry file, followed by the key and the sections.
+// Each section has a 16 byte tag, the suffix of its file name or "*" for the listing, then its length and bytes; an empty tag ends the entry.
+static const char CacheSig[] = "CasZ80" "\032" "\n";
+static const size_t TagN = 0x10;
+
+// FNV-1a, continued from Hash over BufN bytes at Buf.
+uint64_t HashBytes(uint64_t Hash, const void *Buf, size_t BufN) {
+   for (const uint8_t *BP = (const uint8_t *)Buf; BufN > 0; BufN--) Hash = (Hash ^ *BP++)*0x100000001b3ULL;
+   return Hash;
+}
+
+static void CachePath(char *Path, size_t PathN, const char *File) { snprintf(Path, PathN, "%s/%s", CacheDir, File); }
+
+static void EntryPath(char *Path, size_t PathN, uint64_t Key) {
+   char File[0x20]; snprintf(File, sizeof File, "%016llx.cas", (unsigned long long)Key);
+   CachePath(Path, PathN, File);
+}
+
+static CacheEntry *AddEntry(uint64_t Key) {
+   if (EntryN >= EntryMax) {
+      EntryMax = EntryMax == 0? 0x40: 2*EntryMax;
+      Entries = (CacheEntry *)realloc(Entries, EntryMax*sizeof *Entries); if (Entries == nullptr) exit(1);
+   }
+   CacheEntry *E = &Entries[EntryN++]; E->Key = Key, E->Size = 0, E->Stamp = 0;
+   return E;
+}
+
+static unsigned long CacheSize(void) {
+   unsigned long Total = 0;
+   for (unsigned E = 0; E < EntryN; E++) Total += Entries[E].Size;
+   return Total;
+}
+
+static void LoadIndex(void) {
+   char Path[PATH_MAX]; CachePath(Path, sizeof Path, "CasZ80.idx");
+   EntryN = 0, Hits = Misses = Tick = 0;
+   FILE *InF = fopen(Path, "r"); if (InF == nullptr) return;
+   if (fscanf(InF, "%lu %lu %lu", &Hits, &Misses, &Tick) != 3) Hits = Misses = Tick = 0;
+   unsigned long long Key; unsigned long Size, Stamp;
+   while (fscanf(InF, "%llx %lu %lu", &Key, &Size, &Stamp) == 3) {
+      CacheEntry *E = AddEntry(Key); E->Size = Size, E->Stamp = Stamp;
+   }
+   fclose(InF);
+}
+
+static CacheEntry *FindEntry(uint64_t Key) {
+   for (unsigned E = 0; E < EntryN; E++) if (Entries[E].Key == Key) return &Entries[E];
+   return nullptr;
+}
+
+// Remove the least recently used entries until the rest fit into the size bound.
+static void Evict(void) {
+   unsigned long Total = CacheSize();
+   while (Total > CacheMax && EntryN > 0) {
+      unsigned Old = 0;
+      for (unsigned E = 1; E < EntryN; E++) if (Entries[E].Stamp < Entries[Old].Stamp) Old = E;
+      char Path[PATH_MAX]; EntryPath(Path, sizeof Path, Entries[Old].Key), remove(Path);
+      Total -= Entries[Old].Size, Entries[Old] = Entries[--EntryN];
+   }
+}
+
+// Add the use of the entry Key to the index as it is now on disk, bound the cache and write the index back.
+// A hit stamps the entry, a miss counts and forgets it, a put stores it with its Size.
+// The index is written to a temporary file of this run and renamed over the old one, so that concurrent runs never see a partial or missing index.
+static void SaveIndex(uint64_t Key, CacheUse Use, uint32_t Size) {
+   LoadIndex();
+   CacheEntry *E = FindEntry(Key);
+   switch (Use) {
+      case UseHit: Hits++; break;
+      case UseMiss: Misses++; if (E != nullptr) *E = Entries[--EntryN], E = nullptr; break;
+      case UsePut: if (E == nullptr) E = AddEntry(Key); E->Size = Size; break;
+   }
+   if (E != nullptr) E->Stamp = ++Tick;
+   Evict();
+   char Path[PATH_MAX], TmpPath[PATH_MAX], File[0x20];
+   snprintf(File, sizeof File, "CasZ80.idx.%016llx", (unsigned long long)Key);
+   CachePath(Path, sizeof Path, "CasZ80.idx"), CachePath(TmpPath, sizeof TmpPath, File);
+   FILE *ExF = fopen(TmpPath, "w"); if (ExF == nullptr) return;
+   fprintf(ExF, "%lu %lu %lu\n", Hits, Misses, Tick);
+   for (unsigned E = 0; E < EntryN; E++)
+      fprintf(ExF, "%016llx %lu %lu\n", (unsigned long long)Entries[E].Key, (unsigned long)Entries[E].Size, (unsigned long)Entries[E].Stamp);
+   if (fclose(ExF) != 0) { remove(TmpPath); return; }
+   if (rename(TmpPath, Path) != 0) remove(Path), rename(TmpPath, Path); // Replaced in place, where rename() can.
+}
+
+static uint32_t GetL(FILE *InF) {
+   uint8_t Buf[4]; if (fread(Buf, 1, 4, InF) != 4) return 0;
+   return Buf[0] | Buf[1] << 8 | Buf[2] << 16 | (uint32_t)Buf[3] << 24;
+}
+
+static void PutL(FILE *ExF, uint32_t L) {
+   uint8_t Buf[4]; Buf[0] = L, Buf[1] = L >> 8, Buf[2] = L >> 16, Buf[3] = L >> 24;
+   fwrite(Buf, 1, 4, ExF);
+}
+
+// Copy N bytes from InF to ExF, or everything if N is UINT32_MAX; return the number of bytes copied.
+static uint32_t CopyBytes(FILE *InF, FILE *ExF, uint32_t N) {
+   char Buf[0x1000]; uint32_t CopyN = 0;
+   while (CopyN < N) {
+      size_t BufN = N - CopyN < sizeof Buf? N - CopyN: sizeof Buf;
+      BufN = fread(Buf, 1, BufN, InF); if (BufN == 0) break;
+      if (ExF != nullptr) fwrite(Buf, 1, BufN, ExF);
+      CopyN += BufN;
+   }
+   return CopyN;
+}
+
+void OpenCache(const char *Dir, unsigned long MaxKB) {
+   CacheDir = Dir, CacheMax = MaxKB*0x400;
+   LoadIndex();
+}
+
+// Go over the sections of an entry, from InF on: with Stem, restore each file section to "<Stem><Suffix>" and the listing to stdout,
+// or else only skip them; return false, if the entry is cut short.
+static bool GetSections(FILE *InF, const char *Stem) {
+   while (true) {
+      char Tag[TagN + 1]; if (fread(Tag, 1, TagN, InF) != TagN) return false;
+      Tag[TagN] = '\0'; if (Tag[0] == '\0') return true;
+      uint32_t N = GetL(InF);
+      FILE *ExF = Stem == nullptr? nullptr: stdout;
+      if (Stem != nullptr && strcmp(Tag, "*") != 0) {
+         char ExFile[PATH_MAX]; snprintf(ExFile, sizeof ExFile, "%s%s", Stem, Tag);
+         ExF = fopen(ExFile, "wb");
+         if (ExF == nullptr) { fprintf(stderr, "Error: Can't open output file \"%s\".\n", ExFile); exit(1); }
+      }
+      bool Ok = CopyBytes(InF, ExF, N) == N;
+      if (ExF != nullptr && ExF != stdout) fclose(ExF);
+      if (!Ok) return false;
+   }
+}
+
+// Restore the outputs of a cached run: each file section to "<Stem><Suffix>" and the listing to stdout.
+// The whole entry is checked before any of the outputs is written, so a damaged entry leaves them as they were.
+bool GetCache(uint64_t Key, const char *Stem) {
+   if (CacheDir == nullptr) return false;
+   CacheEntry *E = FindEntry(Key);
+   FILE *InF = nullptr;
+   char Path[PATH_MAX]; EntryPath(Path, sizeof Path, Key);
+   if (E != nullptr) InF = fopen(Path, "rb");
+   char Sig[sizeof CacheSig];
+   bool Ok = InF != nullptr && fread(Sig, 1, sizeof CacheSig - 1, InF) == sizeof CacheSig - 1 && memcmp(Sig, CacheSig, sizeof CacheSig - 1) == 0;
+   uint64_t InKey = 0;
+   if (Ok) InKey = GetL(InF), InKey |= (uint64_t)GetL(InF) << 32, Ok = InKey == Key;
+   long At = Ok? ftell(InF): -1;
+   Ok = Ok && At >= 0 && GetSections(InF, nullptr) && fseek(InF, At, SEEK_SET) == 0 && GetSections(InF, Stem);
+   if (InF != nullptr) fclose(InF);
+   SaveIndex(Key, Ok? UseHit: UseMiss, 0); // A missing or damaged entry is forgotten.
+   if (Ok) fprintf(stderr, "Cache hit: %lu hits, %lu misses, %u entries, %lu bytes\n", Hits, Misses, EntryN, CacheSize());
+   return Ok;
+}
+
+// Store the outputs of a run: the files "<Stem><Suffix>" for each Suffix in Suffixes[0⋯SuffixN) and the listing saved in ListF.
+void PutCache(uint64_t Key, const char *Stem, const char *const *Suffixes, int SuffixN, FILE *ListF) {
+   if (CacheDir == nullptr) return;
+   char Path[PATH_MAX], TmpPath[PATH_MAX + 4]; EntryPath(Path, sizeof Path, Key);
+   snprintf(TmpPath, sizeof TmpPath, "%s.tmp", Path);
+   FILE *ExF = fopen(TmpPath, "wb");
+   if (ExF == nullptr) { fprintf(stderr, "Warning: cannot write to the cache \"%s\"\n", CacheDir); return; }
+   fwrite(CacheSig, 1, sizeof CacheSig - 1, ExF), PutL(ExF, (uint32_t)Key), PutL(ExF, (uint32_t)(Key >> 32));
+   char Tag[TagN];
+   for (int X = 0; X < SuffixN; X++) {
+      char InFile[PATH_MAX]; snprintf(InFile, sizeof InFile, "%s%s", Stem, Suffixes[X]);
+      FILE *InF = fopen(InFile, "rb"); if (InF == nullptr) continue;
+      fseek(InF, 0, SEEK_END); uint32_t N = ftell(InF); fseek(InF, 0, SEEK_SET);
+      memset(Tag, 0, TagN), strncpy(Tag, Suffixes[X], TagN - 1);
+      fwrite(Tag, 1, TagN, ExF), PutL(ExF, N), CopyBytes(InF, ExF, N);
+      fclose(InF);
+   }
+   fflush(ListF), fseek(ListF, 0, SEEK_END); uint32_t N = ftell(ListF); fseek(ListF, 0, SEEK_SET);
+   memset(Tag, 0, TagN), Tag[0] = '*';
+   fwrite(Tag, 1, TagN, ExF), PutL(ExF, N), CopyBytes(ListF, ExF, N);
+   memset(Tag, 0, TagN), fwrite(Tag, 1, TagN, ExF);
+   uint32_t Size = ftell(ExF);
+   if (fclose(ExF) != 0) { remove(TmpPath); return; }
+   if (rename(TmpPath, Path) != 0) remove(Path), rename(TmpPath, Path);
+   SaveIndex(Key, UsePut, Size);
+   fprintf(stderr, "Cache miss: %lu hits, %lu misses, %u entries, %lu bytes\n", Hits, Misses, EntryN, CacheSize());
+}
@@ -1,5 +1,6 @@
 // Z80 Assembler.
 #include <cctype>
+#include <csetjmp>
 #include <cstdarg>
 #include <cstdio>
 #include <cstdlib>
@@ -14,59 +15,151 @@ static const uint32_t MaxRAM = 0x10000;
 static uint32_t LoPC = MaxRAM, HiPC = 0;
 static bool Listing = false;
 static FILE *AsmF, *BinF, *Z80F, *HexF;
+FILE *ListF; // The listing and the other console output: stdout, or a temporary file while filling the cache.
 static long LineNo; // The current line number.
+static jmp_buf LineJmp; // Where to resume, at the next line, after an error.
+static bool InLines = false; // True while assembling the lines, i.e. while LineJmp is valid.
+static unsigned long ErrN = 0, ErrMax = 20; // The errors so far and the limit (0: no limit).
+
+// Multi-variant assembly (-D).
+// Each line is tokenized once, then compiled for each variant with its own symbols, IF state, PC and RAM.
+// Between lines the globals hold the state of variant 0.
+struct Variant {
+   const char *Defs;	// The variable settings, "Name=Value,⋯".
+   uint8_t *RAM;
+   uint32_t CurPC, LoPC, HiPC;
+   bool PassOver, AtEnd;
+   SectionSetP Sections;
+};
+static const int VarMax = 0x20;
+static Variant Vars[VarMax];
+int VarN = 1;		// The number of variants.
+static int CurVar = -1;	// The variant being compiled, or -1 outside of the variant loop.
+static int LoadedVar = 0;	// The variant whose state is in the globals.
 static char LineBuf[LineMax]; // A buffer for the current line.
 
-// Print a fatal error message and exit.
+// Copy the saved console output to stdout, when it was diverted for the cache.
+static void EndList(void) {
+   if (ListF == stdout) return;
+   fflush(ListF), fseek(ListF, 0, SEEK_SET);
+   char Buf[0x1000];
+   for (size_t BufN; (BufN = fread(Buf, 1, sizeof Buf, ListF)) > 0; ) fwrite(Buf, 1, BufN, stdout);
+}
+
+// Print an error message and resume with the next line, or exit when the error limit is reached.
 void Error(const char *Message) {
-   printf("Error in line %ld: %s\n", LineNo, Message);
+   if (VarN > 1 && CurVar >= 0) fprintf(ListF, "Error in line %ld (variant %d): %s\n", LineNo, CurVar + 1, Message);
+   else fprintf(ListF, "Error in line %ld: %s\n", LineNo, Message);
    const char *p;
    for (p = LineBuf; isspace(*p); p++);
-   puts(p);
+   fprintf(ListF, "%s\n", p);
+   if (++ErrN == ErrMax) fprintf(ListF, "Too many errors, giving up\n");
+   else if (InLines) longjmp(LineJmp, 1);
+   EndList();
    exit(1);
 }
 
+// Report the PC-relative jump with its offset at Addr as out of range: in its line, while compiling, or by its address, once the sections are placed.
+// Its byte is already encoded, so neither the line nor the placement is abandoned.
+void JumpError(uint32_t Addr) {
+   char Variant[0x20] = "";
+   if (VarN > 1) snprintf(Variant, sizeof Variant, " (variant %d)", LoadedVar + 1);
+   if (InLines) fprintf(ListF, "Error in line %ld%s: Relative jump at %04X out of range\n", LineNo, Variant, Addr - 1);
+   else fprintf(ListF, "----    Relative jump at %04X out of range%s\n", Addr - 1, Variant);
+   if (++ErrN == ErrMax) fprintf(ListF, "Too many errors, giving up\n"), EndList(), exit(1);
+}
+
+static void LoadVariant(int V) {
+   const Variant &Va = Vars[V];
+   LoadedVar = V, RAM = Va.RAM, CurPC = Va.CurPC, LoPC = Va.LoPC, HiPC = Va.HiPC, PassOver = Va.PassOver, AtEnd = Va.AtEnd, Sections = Va.Sections;
+}
+
+static void SaveVariant(int V) {
+   Variant &Va = Vars[V];
+   Va.RAM = RAM, Va.CurPC = CurPC, Va.LoPC = LoPC, Va.HiPC = HiPC, Va.PassOver = PassOver, Va.AtEnd = AtEnd, Va.Sections = Sections;
+}
+
+// Compile the line in CmdBuf for the variants V0⋯VarN-1, then go back to variant 0.
+// Each variant gets the tokens as tokenized for variant 0, with its own copies of the symbols and its own "$".
+static void CompileVariants(int V0) {
+   static Command Line0[sizeof CmdBuf/sizeof CmdBuf[0]];
+   static uint8_t PCRefs0[sizeof PCRefs], PCRefN0;
+   if (V0 == 0) memcpy(Line0, CmdBuf, sizeof Line0), memcpy(PCRefs0, PCRefs, sizeof PCRefs0), PCRefN0 = PCRefN;
+   for (int V = V0; V < VarN; V++) {
+      CurVar = V, LoadVariant(V);
+      if (!AtEnd) {
+         if (V > 0) {
+            for (CommandP Cmd = CmdBuf, Cmd0 = Line0; ; Cmd++, Cmd0++) {
+               *Cmd = *Cmd0;
+               if (Cmd->Type == SymL) Cmd->Value = (long)VarSymbol((SymbolP)Cmd->Value, V);
+               else if (Cmd->Type == BadL) break;
+            }
+            for (int R = 0; R < PCRefN0; R++) CmdBuf[PCRefs0[R]].Value = CurPC;
+         }
+         BegLinePatches(), CompileLine();
+      }
+      SaveVariant(V);
+   }
+   CurVar = -1, LoadVariant(0);
+// Keep on until every variant has reached its end.
+   for (int V = 0; V < VarN; V++) if (!Vars[V].AtEnd) { AtEnd = false; break; } else AtEnd = true;
+}
+
 static void Usage(const char *Path) {
    const char *App = Path;
    for (char Ch; (Ch = *Path++) != '\0'; ) if (Ch == '/' || Ch == '\\') App = Path;
    printf(
       "Usage: %s [-l] [-n] <InFile>\n"
       "  -c       CP/M com file format for binary\n"
+      "  -DN=V,⋯  add a variant with the symbols N set to V (repeatable)\n"
+      "  -eN      stop after N errors (default: 20, 0: no limit)\n"
       "  -fXX     fill ram with byte XX (default: 00)\n"
+      "  -kDir    cache the outputs in the directory Dir\n"
       "  -l       show listing\n"
+      "  -mN      bound the cache to N KiB (default: 65536)\n"
       "  -n       no output files\n"
-      "  -oXXXX   offset address = 0x0000 .. 0xFFFF\n",
+      "  -oXXXX   offset address = 0x0000 .. 0xFFFF\n"
+      "  -u       remove the unreferenced sections\n"
+      "  -wFile   save the defined symbols to the snapshot File\n"
+      "  -yFile   load the symbols from the snapshot File (repeatable)\n",
       App
    );
 }
 
+// The address of a listed line; in a section, which is not yet placed, it is its offset in the section, "+XXXX", to be added to its place in the map.
+static void ListAddr(uint32_t PC) {
+   if (PC < StageBeg) fprintf(ListF, "%4.4X   ", PC);
+   else fprintf(ListF, "+%4.4X  ", PC - (Sections->Cur >= 0? Sections->Sects[Sections->Cur].Stage: StageBeg));
+}
+
 // Create a listing for one source code line.
 //	Address    Data Bytes    Source Code
 // Break long data block (e.g. defm) into lines of 4 data bytes.
 static void ListOneLine(uint32_t BegPC, uint32_t EndPC, const char *Line) {
    if (!Listing) return;
-   if (BegPC == EndPC) printf("%*s\n", 24 + int(strlen(Line)), Line);
+   if (BegPC == EndPC) fprintf(ListF, "%*s\n", 24 + int(strlen(Line)), Line);
    else {
-      printf("%4.4X   ", BegPC);
+      ListAddr(BegPC);
       uint32_t PC = BegPC;
       int n = 0;
       while (PC < EndPC) {
-         printf(" %2.2X", RAM[PC++]);
-         if (n == 3) printf("     %s", Line);
+         fprintf(ListF, " %2.2X", RAM[PC++]);
+         if (n == 3) fprintf(ListF, "     %s", Line);
          if ((n&3) == 3) {
-            printf("\n");
-            if (PC < EndPC) printf("%4.4X   ", PC);
+            fprintf(ListF, "\n");
+            if (PC < EndPC) ListAddr(PC);
          }
          n++;
       }
-      if (n < 4) printf("%*s\n", 5 + 3*(4 - n) + int(strlen(Line)), Line);
-      else if ((n&3) != 0) printf("\n");
+      if (n < 4) fprintf(ListF, "%*s\n", 5 + 3*(4 - n) + int(strlen(Line)), Line);
+      else if ((n&3) != 0) fprintf(ListF, "\n");
    }
 }
 
+// List, if requested: with variants, only for variant 0, as with the lines, and so also the back-patches.
 void List(const char *Format, ...) {
-   if (Listing) {
-      va_list AP; va_start(AP, Format), vprintf(Format, AP), va_end(AP);
+   if (Listing && LoadedVar == 0) {
+      va_list AP; va_start(AP, Format), vfprintf(ListF, Format, AP), va_end(AP);
    }
 }
 
@@ -83,12 +176,56 @@ static void PutHeader(FILE *ExF, uint32_t Addr) {
    fwrite(Signature, 1, strlen(Signature), ExF), fwrite(Buf, 1, 2, ExF);
 }
 
+// Open the out file "<Stem><Variant>.<Ext>" and return its suffix after the stem.
+static FILE *OpenExFile(const char *Stem, const char *Variant, const char *Ext, const char *&Suffix) {
+   char ExFile[PATH_MAX]; snprintf(ExFile, sizeof ExFile, "%s%s.%s", Stem, Variant, Ext);
+   Suffix = strdup(ExFile + strlen(Stem));
+   FILE *ExF = fopen(ExFile, "wb");
+   if (ExF == nullptr) fprintf(stderr, "Error: Can't open output file \"%s\".\n", ExFile);
+   return ExF;
+}
+
+// Compile the lines of the source.
+// An error abandons the rest of its line and comes back here, with the patches made by the line dropped,
+// so the loop itself carries no recovery cost; with variants, the line is still compiled for the variants after the one in error.
+// This is kept out of main(), so that none of its variables are left in doubt by the longjmp().
+static void CompileLines(void) {
+   LineNo = 0, InLines = true;
+   if (setjmp(LineJmp) != 0) {
+      DropLinePatches();
+      if (CurVar >= 0) SaveVariant(CurVar), CompileVariants(CurVar + 1);
+   }
+   while (!AtEnd) { // For each line:
+   // Start its patches before it is tokenized, so that an error anywhere in it drops only its own.
+      BegLinePatches();
+      uint32_t BegPC = CurPC; bool BegInSection = Sections->Cur >= 0;
+   // Read a single line; exit at the end of the code.
+      char *Line = fgets(LineBuf, sizeof LineBuf, AsmF); if (Line == nullptr) break;
+      LineNo++;
+   // Remove the end of line marker, tokenize the line, convert it to machine code.
+      Line[strlen(Line) - 1] = '\0', TokenizeLine(Line);
+      if (VarN == 1) CompileLine(); else CompileVariants(0);
+   // List, if requested (only variant 0, with variants); a section is listed by its offsets.
+      if (BegInSection != (Sections->Cur >= 0)) BegPC = CurPC;
+      ListOneLine(BegPC, CurPC, Line);
+   }
+   InLines = false;
+}
+
+// The version of the outputs and the listing, in the cache key: it is to be changed with any change to the encoder or to their formats,
+// so that the entries cached by an older CasZ80 are not replayed.
+static const char OutVersion[] = "CasZ80 2";
+
 int main(int AC, char **AV) {
    char *InFile = nullptr;
    bool IsCom = false;
    int BasePC = 0;
    int Fill = 0;
    bool NoAsmF = false;
+   bool Prune = false;
+   const char *CacheDir = nullptr; unsigned long CacheKB = 0x10000;
+   const char *SymExFile = nullptr, *SymInFiles[0x10]; int SymInN = 0;
+   int DefN = 0;
    fprintf(stderr, "CasZ80 - a small 1-pass assembler for Z80 code\n");
    fprintf(stderr, "Based on TurboAss Z80 (c)1992-1993 Sigma-Soft, Markus Fritze\n");
    for (int A = 1, Ax = 0; A < AC; A++)
@@ -96,6 +233,30 @@ int main(int AC, char **AV) {
          switch (AV[A][++Ax]) {
          // Create a CP/M com file.
             case 'c': IsCom = true; break;
+         // A variant.
+            case 'D': {
+               const char *Defs = nullptr;
+            // "-DName=Value,⋯"
+               if (AV[A][++Ax] != '\0') Defs = AV[A] + Ax;
+            // "-D Name=Value,⋯"
+               else if (A < AC - 1) Defs = AV[++A];
+               if (Defs == nullptr) { fprintf(stderr, "Error: option -D needs a Name=Value list\n"); return 1; }
+               if (DefN >= VarMax) { fprintf(stderr, "Error: too many variants (at most %d)\n", VarMax); return 1; }
+               Vars[DefN++].Defs = Defs;
+               Ax = 0; // The end of this arg group.
+            }
+            break;
+         // The error limit.
+            case 'e': {
+               int InN = 0;
+            // "-eN"
+               if (AV[A][++Ax] != '\0') InN = sscanf(AV[A] + Ax, "%lu", &ErrMax);
+            // "-e N"
+               else if (A < AC - 1) InN = sscanf(AV[++A], "%lu", &ErrMax);
+               if (InN <= 0) { fprintf(stderr, "Error: option -e needs a decimal argument\n"); return 1; }
+               Ax = 0; // The end of this arg group.
+            }
+            break;
          // Fill.
             case 'f': {
                int InN = 0;
@@ -108,9 +269,29 @@ int main(int AC, char **AV) {
                Ax = 0; // The end of this arg group.
             }
             break;
-         // Parse the program flow.
+         // The cache directory.
+            case 'k':
+            // "-kDir"
+               if (AV[A][++Ax] != '\0') CacheDir = AV[A] + Ax;
+            // "-k Dir"
+               else if (A < AC - 1) CacheDir = AV[++A];
+               else { fprintf(stderr, "Error: option -k needs a directory argument\n"); return 1; }
+               Ax = 0; // The end of this arg group.
+            break;
+         // Show the listing.
             case 'l': Listing = true; break;
-         // Parse the program flow.
+         // The cache size bound.
+            case 'm': {
+               int InN = 0;
+            // "-mN"
+               if (AV[A][++Ax] != '\0') InN = sscanf(AV[A] + Ax, "%lu", &CacheKB);
+            // "-m N"
+               else if (A < AC - 1) InN = sscanf(AV[++A], "%lu", &CacheKB);
+               if (InN <= 0) { fprintf(stderr, "Error: option -m needs a decimal argument\n"); return 1; }
+               Ax = 0; // The end of this arg group.
+            }
+            break;
+         // No output files.
             case 'n': NoAsmF = true; break;
          // The program offset.
             case 'o': {
@@ -124,6 +305,30 @@ int main(int AC, char **AV) {
                Ax = 0; // The end of this arg group.
             }
             break;
+         // Remove the unreferenced sections.
+            case 'u': Prune = true; break;
+         // Save a symbol snapshot.
+            case 'w':
+            // "-wFile"
+               if (AV[A][++Ax] != '\0') SymExFile = AV[A] + Ax;
+            // "-w File"
+               else if (A < AC - 1) SymExFile = AV[++A];
+               else { fprintf(stderr, "Error: option -w needs a file argument\n"); return 1; }
+               Ax = 0; // The end of this arg group.
+            break;
+         // Load a symbol snapshot.
+            case 'y': {
+               const char *SymInFile = nullptr;
+            // "-yFile"
+               if (AV[A][++Ax] != '\0') SymInFile = AV[A] + Ax;
+            // "-y File"
+               else if (A < AC - 1) SymInFile = AV[++A];
+               if (SymInFile == nullptr) { fprintf(stderr, "Error: option -y needs a file argument\n"); return 1; }
+               if (SymInN >= int(sizeof SymInFiles/sizeof SymInFiles[0])) { fprintf(stderr, "Error: too many symbol snapshots\n"); return 1; }
+               SymInFiles[SymInN++] = SymInFile;
+               Ax = 0; // The end of this arg group.
+            }
+            break;
             default: Usage(AV[0]); return 1;
          }
       // If one more arg char, keep this arg group.
@@ -135,68 +340,119 @@ int main(int AC, char **AV) {
    if (InFile == nullptr) { Usage(AV[0]); return 1; }
    AsmF = fopen(InFile, "r");
    if (AsmF == nullptr) { fprintf(stderr, "Error: cannot open infile %s\n", InFile); return 1; }
+   ListF = stdout;
+// The output files are named after the in file.
+   bool DoAsmF = !NoAsmF && strlen(InFile) > 4 && strcmp(InFile + strlen(InFile) - 4, ".asm") == 0;
+   char Stem[PATH_MAX]; strncpy(Stem, InFile, sizeof Stem - 1), Stem[sizeof Stem - 1] = '\0';
+   if (DoAsmF) Stem[strlen(Stem) - 4] = '\0';
+// The hash of the source bytes, for the cache key and the symbol snapshot.
+   uint64_t SrcHash = HashInit;
+   if (CacheDir != nullptr || SymExFile != nullptr) {
+      char Buf[0x1000];
+      for (size_t BufN; (BufN = fread(Buf, 1, sizeof Buf, AsmF)) > 0; ) SrcHash = HashBytes(SrcHash, Buf, BufN);
+      fseek(AsmF, 0, SEEK_SET);
+   }
+// The key: the version of the outputs, the source bytes, the options that change the outputs or the listing, and the loaded symbol snapshots.
+   char Opts[0x40]; int OptsN = snprintf(Opts, sizeof Opts, "%s c%d f%02X o%04X l%d n%d u%d", OutVersion, IsCom, Fill, BasePC, Listing, DoAsmF, Prune);
+   uint64_t Key = HashBytes(SrcHash, Opts, OptsN);
+   for (int V = 0; V < DefN; V++) Key = HashBytes(Key, Vars[V].Defs, strlen(Vars[V].Defs) + 1);
    InitSymTab(); // Initialize the symbol table.
-   RAM = (uint8_t *)malloc(MaxRAM + 0x100); // Guard against overflow at the RAM top.
-   memset(RAM, Fill, MaxRAM); // Erase the 64K RAM.
-   CurPC = 0x0000; // The default start address of the code.
-   for (LineNo = 1; !AtEnd; LineNo++) { // For each line:
-      uint32_t BegPC = CurPC;
-   // Read a single line; exit at the end of the code.
-      char *Line = fgets(LineBuf, sizeof LineBuf, AsmF); if (Line == nullptr) break;
-   // Remove the end of line marker, tokenize the line, convert it to machine code.
-      Line[strlen(Line) - 1] = '\0', TokenizeLine(Line), CompileLine();
-   // List, if requested.
-      ListOneLine(BegPC, CurPC, Line);
+   for (int S = 0; S < SymInN; S++) if (!LoadSymbols(SymInFiles[S], Key)) return 1;
+// Set up the variants and their symbols.
+   if (DefN > 1) VarN = DefN, SplitSymbols();
+   for (int V = 0; V < DefN; V++) for (const char *DP = Vars[V].Defs; *DP != '\0'; ) {
+      char Name[NameMax + 2]; int N = 0;
+      for (; *DP != '\0' && *DP != '=' && *DP != ','; DP++) if (N <= NameMax) Name[N++] = *DP;
+      Name[N] = '\0';
+      long Value = 1; // A symbol with no value is set to 1.
+      if (*DP == '=') {
+         char *EndP; Value = strtol(++DP, &EndP, 0);
+         if (EndP == DP || *EndP != '\0' && *EndP != ',') { fprintf(stderr, "Error: bad value for %s in -D %s\n", Name, Vars[V].Defs); return 1; }
+         DP = EndP;
+      }
+      if (*DP == ',') DP++;
+      if (!DefineSymbol(Name, Value, V)) { fprintf(stderr, "Error: cannot define %s in -D %s\n", Name, Vars[V].Defs); return 1; }
+   }
+// A run that saves a snapshot is always done in full.
+   if (CacheDir != nullptr && SymExFile == nullptr) {
+      OpenCache(CacheDir, CacheKB);
+      if (GetCache(Key, Stem)) { fclose(AsmF); return 0; }
+      ListF = tmpfile(); if (ListF == nullptr) ListF = stdout;
    }
+   for (int V = 0; V < VarN; V++) {
+   // The 64K RAM, followed by the staging area for the sections.
+      RAM = (uint8_t *)malloc(StageEnd + 0x100); // Guard against overflow at the RAM top.
+      if (RAM == nullptr) { fprintf(stderr, "Error: out of memory\n"); return 1; }
+      memset(RAM, Fill, StageEnd); // Erase the RAM.
+      CurPC = 0x0000; // The default start address of the code.
+      Sections = NewSections();
+      SaveVariant(V);
+   }
+   LoadVariant(0);
+   CompileLines();
+   if (VarN == 1) SaveVariant(0);
    List("\n");
    fclose(AsmF);
+// Place the sections.
+   for (int V = 0; V < VarN; V++) {
+      LoadVariant(V); int PlaceErrN = PlaceSections(V, Prune, LoPC, HiPC);
+      ErrN += PlaceErrN, SaveVariant(V);
+   }
+   LoadVariant(0);
 // Cross-reference.
 // Iterate over the symbol table.
-   for (int S = 0; S < 0x100; S++) for (SymbolP Sym = SymTab[S]; Sym != nullptr; Sym = Sym->Next)
+   for (int S = 0; S < 0x100; S++) for (SymbolP Sym = SymTab[S]; Sym != nullptr; Sym = Sym->Next) {
    // Do expressions depend on a symbol?
-      if (Sym->Patch != nullptr) printf("----    %s is undefined!\n", Sym->Name);
+      if (Sym->Patch != nullptr) fprintf(ListF, "----    %s is undefined!\n", Sym->Name), ErrN++;
+      else if (Sym->Type == 0 && Sym->Deferred) List("----    %s removed\n", Sym->Name);
       else if (Sym->Type == 0) List("%04X%*s\n", Sym->Value, 20 + int(strlen(Sym->Name)), Sym->Name);
-   if (LoPC < 0x100 || HiPC <= 0x100) IsCom = false; // Cannot be a CP/M com file.
-   if (Listing) {
-      if (LoPC <= HiPC) printf("\nUsing RAM range [0x%04X...0x%04X]\n", LoPC, HiPC);
-      else printf("\nNo data created\n"), exit(1);
+      if (Sym->Type == 0 && Sym->Var != nullptr) for (int V = 1; V < VarN; V++) {
+         SymbolP VSym = VarSymbol(Sym, V);
+         if (VSym->Patch != nullptr) fprintf(ListF, "----    %s is undefined in variant %d!\n", Sym->Name, V + 1), ErrN++;
+      }
+   }
+// No output files after any error.
+   if (ErrN > 0) fprintf(ListF, "%lu error%s\n", ErrN, ErrN == 1? "": "s"), EndList(), exit(1);
+   if (SymExFile != nullptr && !SaveSymbols(SymExFile, InFile, SrcHash)) {
+      fprintf(stderr, "Error: cannot write symbol snapshot \"%s\"\n", SymExFile);
+      return 1;
    }
-   char ExFile[PATH_MAX];
-   if (!NoAsmF && strlen(InFile) > 4 && strcmp(InFile + strlen(InFile) - 4, ".asm") == 0) {
-      strncpy(ExFile, InFile, sizeof ExFile);
-   // Create a out file name(s) from the in file name.
-      size_t ExFileN = strlen(ExFile);
+   const char *Suffixes[3*VarMax]; int SuffixN = 0;
+   for (int V = 0; V < VarN; V++) {
+      LoadVariant(V);
+      bool VarIsCom = IsCom && LoPC >= 0x100 && HiPC > 0x100; // Otherwise, it cannot be a CP/M com file.
+      if (Listing) {
+         if (VarN > 1) fprintf(ListF, "\nVariant %d: %s", V + 1, Vars[V].Defs);
+         if (LoPC <= HiPC) fprintf(ListF, "\nUsing RAM range [0x%04X...0x%04X]\n", LoPC, HiPC);
+         else fprintf(ListF, "\nNo data created\n"), EndList(), exit(1);
+      }
+      if (!DoAsmF) continue;
+   // Create the out file names from the in file name, with the variant number, if there is more than one variant.
+      char Variant[0x10] = "";
+      if (VarN > 1) snprintf(Variant, sizeof Variant, "_%d", V + 1);
    // Make it a bin or com (= bin file that starts at PC = 0x100) file.
-      strncpy(ExFile + ExFileN - 3, IsCom? "com": "bin", sizeof ExFile - ExFileN - 3);
-      BinF = fopen(ExFile, "wb");
-      if (BinF == nullptr) { fprintf(stderr, "Error: Can't open output file \"%s\".\n", ExFile); return 1; }
+      BinF = OpenExFile(Stem, Variant, VarIsCom? "com": "bin", Suffixes[SuffixN++]); if (BinF == nullptr) return 1;
    // A Z80 file is a bin file with a header telling the file offset.
-      strncpy(ExFile + ExFileN - 3, "z80", sizeof ExFile - ExFileN - 3);
-      Z80F = fopen(ExFile, "wb");
-      if (Z80F == nullptr) { fprintf(stderr, "Error: Can't open output file \"%s\".\n", ExFile); return 1; }
+      Z80F = OpenExFile(Stem, Variant, "z80", Suffixes[SuffixN++]); if (Z80F == nullptr) return 1;
    // Intel Hex file.
-      strncpy(ExFile + ExFileN - 3, "hex", sizeof ExFile - ExFileN - 3);
-      HexF = fopen(ExFile, "wb");
-      if (HexF == nullptr) { fprintf(stderr, "Error: Can't open output file \"%s\".\n", ExFile); return 1; }
-   }
-   if (BinF != nullptr) {
-      if (IsCom) BasePC = 0x100;
-      fwrite(RAM + BasePC, sizeof RAM[0], HiPC + 1 - BasePC, BinF);
-      fclose(BinF);
-   }
-   if (Z80F != nullptr) PutHeader(Z80F, LoPC), fwrite(RAM + LoPC, sizeof RAM[0], HiPC + 1 - LoPC, Z80F);
-   if (HexF != nullptr) {
-   {
-   // Write the data as Intel Hex.
-      HexEx Q; Q.PutAtAddr(LoPC), Q.Put(RAM + LoPC, HiPC + 1 - LoPC);
-   }
+      HexF = OpenExFile(Stem, Variant, "hex", Suffixes[SuffixN++]); if (HexF == nullptr) return 1;
+      uint32_t VarPC = VarIsCom? 0x100: BasePC;
+      fwrite(RAM + VarPC, sizeof RAM[0], HiPC + 1 - VarPC, BinF), fclose(BinF);
+      PutHeader(Z80F, LoPC), fwrite(RAM + LoPC, sizeof RAM[0], HiPC + 1 - LoPC, Z80F), fclose(Z80F);
+      {
+      // Write the data as Intel Hex.
+         HexEx Q; Q.PutAtAddr(LoPC), Q.Put(RAM + LoPC, HiPC + 1 - LoPC);
+      }
       fclose(HexF);
    }
+   if (ListF != stdout) PutCache(Key, Stem, Suffixes, SuffixN, ListF), EndList();
    return 0;
 }
 
 void CheckPC(uint32_t PC) {
-   if (PC >= MaxRAM) Error("Address overflow -> exit"), exit(0);
+// The staging area of a section is not part of the address range.
+   if (Sections->Cur >= 0) { if (PC >= StageEnd) Error("Section overflow"); return; }
+   if (PC >= MaxRAM) Error("Address overflow");
    if (PC < LoPC) LoPC = PC;
    if (PC > HiPC) HiPC = PC;
 }
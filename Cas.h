@@ -3,6 +3,7 @@
 #define DEBUG 0
 
 #include <cstdint>
+#include <cstdio>
 
 enum Lexical {
    BadL,
@@ -19,13 +20,13 @@ enum Lexical {
 
 // Lexical classes for OpL type tokens.
 #define _Lit 0x000	// 000⋯0ff: Character Literals.
-#define _OpP 0x100	// 100⋯10b: Pseudo-Operators: db,dm,ds,dw,end,equ,org,if,endif,else,print,fill; but also 120-121: ">>","<<".
+#define _OpP 0x100	// 100⋯10d: Pseudo-Operators: db,dm,ds,dw,end,equ,org,if,endif,else,print,fill,section,ends; but also 120-121: ">>","<<".
 #define _Op 0x200	// 200⋯20f: Mnemonic classes; 280⋯281: Data and Addresses
 #define _Reg 0x300	// 300⋯3ff: Registers; leads also to 500⋯5ff: (Register), 600⋯6ff: (Register+Index)
 #define _Cc 0x400	// 400⋯407: Conditions: NZ,Z,NC,C,PO,PE,P,M
 
 // Pseudo-Operators.
-enum PseudoT { _db = 0x100, _dm, _ds, _dw, _end, _equ, _org, _if, _endif, _else, _print, _fill };
+enum PseudoT { _db = 0x100, _dm, _ds, _dw, _end, _equ, _org, _if, _endif, _else, _print, _fill, _section, _ends };
 
 // Mnemonic operators and operator classes.
 // _POp		in A,(Pb); out (Pb),A.
@@ -101,26 +102,88 @@ struct Symbol {
    int32_t Value;		// The symbol's value.
    unsigned Defined:1;		// True, if the symbol is defined.
    unsigned First:1;		// True, if the symbol is already valid.
+   unsigned Deferred:1;		// True, if the symbol is a section label, to be defined when its section is placed.
    PatchListP Patch;		// Expressions depended on this symbol (for back-patching).
+   SymbolP Var;			// The symbol's copies for variants 1⋯VarN-1 (multi-variant assembly), or nullptr.
+};
+
+// A relocatable section, "SECTION" ⋯ "ENDS".
+// It is assembled into a staging area above the 64K address space and is copied to its place after the last line.
+#define StageBeg 0x10000	// The staging area for the sections: StageBeg⋯StageEnd-1 in RAM.
+#define StageEnd 0x20000
+struct Section {
+   uint32_t Stage, Size;	// The staging address and the size.
+   uint32_t Base;		// The placed address.
+   bool Live;			// False, if the section is removed as unreferenced.
+   bool Placed;			// True, if the section found room.
+};
+
+// A PC-relative byte in a section with its target outside of the sections, redone when the section is placed.
+struct RelFix {
+   uint32_t Addr;
+   int32_t Target;
+};
+
+// The sections of a variant.
+typedef struct SectionSet *SectionSetP;
+struct SectionSet {
+   Section *Sects; int SectN, SectMax;
+   SymbolP *Labels; int LabelN, LabelMax;	// The section labels.
+   RelFix *Fixes; int FixN, FixMax;
+   int Cur;		// The open section, or -1.
+   uint32_t FixPC;	// The PC of the fixed code, while a section is open.
+   uint32_t StagePC;	// The staging address of the next section.
+   uint8_t Used[0x2000];	// A bit for each byte of the 64K address space used by the fixed code.
 };
 
 // From Lex.cpp:
 extern Command CmdBuf[80];	// A tokenized line.
 extern SymbolP SymTab[0x100];	// The symbol table (split by the upper hash byte).
+extern uint8_t PCRefs[80], PCRefN;	// The tokens in CmdBuf that stand for "$", the current PC.
 void InitSymTab(void);		// Initialize the symbol table.
 void TokenizeLine(char *Line);	// Tokenize a single line.
+SymbolP VarSymbol(SymbolP Sym, int V);				// The copy of a symbol for variant V.
+void SplitSymbols(void);					// Copy the symbols defined so far to all the variants.
+bool DefineSymbol(const char *Name, int32_t Value, int V);	// Define a symbol in variant V.
+bool SaveSymbols(const char *File, const char *Source, uint64_t Hash);	// Save the defined symbols to a snapshot.
+bool LoadSymbols(const char *File, uint64_t &Hash);			// Load the symbols from a snapshot.
 
 // From Exp.cpp:
 extern PatchListP LastPatch;	// To patch the type for incomplete formulas.
 int32_t GetExp(CommandP &Cmd);	// Calculate an expression.
+void BegLinePatches(void);	// Start the patches of a line.
+void KeepLastPatch(void);	// Keep the last patch, as not one of the line's own.
+void DropLinePatches(void);	// Drop the patches of a line abandoned by an error.
 
 // From Syn.cpp:
 extern bool AtEnd;
+extern bool PassOver;		// Skipping lines in a false IF block.
 void CompileLine(void);		// Compile a line into machine code.
+void ResolvePatches(SymbolP Sym);	// Back-patch the expressions that depend on a newly defined symbol.
 
 // From Cas.cpp:
 extern uint32_t CurPC;			// The current address.
 extern uint8_t *RAM;			// The 64K RAM of the Z80.
-void Error(const char *Message);	// Print a fatal error message and exit.
+extern FILE *ListF;			// The listing and the other console output.
+extern int VarN;			// The number of variants assembled together (-D).
+void Error(const char *Message);	// Print an error message and resume with the next line.
+void JumpError(uint32_t Addr);		// Report the PC-relative byte at Addr as out of range, and go on.
 void List(const char *Format, ...);
 void CheckPC(uint32_t PC);
+
+// From Sec.cpp:
+extern SectionSetP Sections;	// The sections of the variant being compiled.
+SectionSetP NewSections(void);
+void BegSection(void);
+void EndSection(void);
+void DeferLabel(SymbolP Sym);			// Make Sym a label of the open section (or of the one opened on this line).
+void MarkUsed(uint32_t Lo, uint32_t Hi);	// Mark Lo⋯Hi-1 as used by the fixed code.
+void NoteJump(uint32_t Addr, int32_t Target);	// Note a PC-relative byte at Addr to Target, and check its range.
+int PlaceSections(int V, bool Prune, uint32_t LoPC, uint32_t HiPC);	// Place the sections of variant V; return the number of errors.
+
+// From Cache.cpp:
+#define HashInit 0xcbf29ce484222325ULL	// The initial value for HashBytes().
+uint64_t HashBytes(uint64_t Hash, const void *Buf, size_t BufN);
+void OpenCache(const char *Dir, unsigned long MaxKB);
+bool GetCache(uint64_t Key, const char *Stem);
+void PutCache(uint64_t Key, const char *Stem, const char *const *Suffixes, int SuffixN, FILE *ListF);
@@ -3,7 +3,7 @@
 // The program has two parts:
 // ▪	Analyze the code.
 // 	The disassembler tries to analyze what part of the binary data is program code and what part is data.
-// 	It start with all hardware vectors of the Z80 (‟RST” opcodes, ‟NMI”) and parses all jumps via a recursive analyze via ‟OpScan()”.
+// 	It start with all hardware vectors of the Z80 (‟RST” opcodes, ‟NMI”) and follows all jumps with a work list in ‟OpScan()”.
 // 	Every opcode is marked in an array (‟Mode”).
 // 	There are some exceptions, the parser can't recognize:
 // 	―	Self Modifying Code:
@@ -15,8 +15,9 @@
 // 		The set of possible destinations has to be determined by analysis and added separately as entry points.
 // 	―	Indirect Jumps: organized as jump tables.
 // 		These are quite common in a ROM.
-// 		The same applies here, as with calculated branches.
-// 		If you find a jump table - like on Markuz' Futura aquarium computer - more entry points for ‟OpScan()” will need to be added.
+// 		The common patterns (a range check on A, then the index scaled and added to the table base) are resolved by tracking the registers,
+// 		and the table is then output as ‟DEFW” data.
+// 		Others - like on Markuz' Futura aquarium computer - will need more entry points to be added for ‟OpScan()”.
 // 	―	Unused code.
 // 		This can be code that is reached from an unrecognized destination of an indirect jump, or as an unrecognized entry point.
 // 		It if assumes a regular form, consisting particularly of bytes are in the range of printable characters, then it may be initialized data.
@@ -24,12 +25,12 @@
 // 		By default, it is treated as part of the data area of the program
 // ▪	Disassembly of the code.
 // 	With the help of the Mode table the disassembler now creates the output.
-// 	This subroutine is quite long.
 // 	It disassembles one opcode at a specific address in ROM into a buffer.
-// 	It is coded directly from a list of Z80 opcodes, so the handling of ‟IX” and ‟IY” could be optimized quite a lot.
 //
-// The subroutine ‟OpLen()” returns the size of one opcode in bytes.
-// It is called while parsing and while disassembling.
+// The subroutine ‟Decode()” decodes one opcode from tables (‟Pages”) built at compile time:
+// one page of 256 entries for each of the base opcodes and the ‟CB”, ‟ED”, ‟DD”, ‟FD”, ‟DD CB” and ‟FD CB” prefixes,
+// each entry giving the operand format, the length, the control flow and the text template of the opcode.
+// The result is cached by address, next to ‟Mode”, so each opcode is decoded once for both parsing and disassembling.
 //
 // The disassembler recognizes some hidden opcodes.
 //
@@ -41,19 +42,32 @@
 // It may not be used as a base for a commercial product!
 
 #include "HexIn.h"
+#include <cctype>
 #include <cstdarg>
 #include <cstdint>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
+#include <atomic>
+#include <thread>
+#include <vector>
+#ifndef _WIN32
+#   include <sys/mman.h>
+#   include <unistd.h>
+#else
+#   include <fcntl.h>
+#   include <io.h>
+#endif
 
 static const uint32_t CodeMax = 0x10000;
-static uint8_t Code[CodeMax];	// Memory for the code.
-static uint8_t Mode[CodeMax];	// Type of opcode.
+static uint8_t *Code;	// Memory for the code, in the current view.
+static uint8_t *Mode;	// Type of opcode.
 // Values for 'Mode': 0x10: (Bit 4) indicates a jump/call address reference.
-enum { Empty, Opcode, Operand, Data };
+// Word: the first byte of an entry of a jump table; the second is an Operand.
+enum { Empty, Opcode, Operand, Data, Word };
 
 static uint32_t LoRAM = CodeMax, HiRAM = 0;
+static uint32_t SpaceN = CodeMax;	// The size of the address space loaded into: 64K, or 1M for the 8086 and 8088.
 
 static char NumPre = '$';
 
@@ -70,380 +84,2170 @@ static inline uint16_t GetW(uint16_t &IP) {
    uint16_t L = Code[IP++], H = Code[IP++]; return L | H << 8;
 }
 
-// Calculate the length of an opcode.
-static int OpLen(uint16_t IP) {
-   uint16_t IP0 = IP;
-MainOp:
-   switch (GetB(IP)) { // The primary opcode.
-   // ld Rd,Db; [Rd: B; C; D; E; H; L; (HL); A]
-      case 0006: case 0016: case 0026: case 0036: case 0046: case 0056: case 0066: case 0076:
-   // djnz Js; jr Js; jr nz,Js; jr z,Js; jr nc,Js; jr c,Js
-      case 0020: case 0030: case 0040: case 0050: case 0060: case 0070:
-   // AOp Db; [AOp: add A,; adc A,; sub; sbc A,; and; xor; or; cp]
-      case 0306: case 0316: case 0326: case 0336: case 0346: case 0356: case 0366: case 0376:
-   // out (Pb),A; in A,(Pb)
-      case 0323: case 0333:
-   // Shift-,Rotate-,Bit-opcodes.
-      case 0313:
-         IP++;
+// The opcode tables.
+// ─────────────────
+// Each page of opcodes (the base page and those after the prefixes 0313, 0355, 0335 and 0375) has a table of 256 entries, built at compile time.
+// An entry gives the operand format (and so the length), the flow kind and a template for the text, in which:
+//	%y, %z	the register Rb[Y] or Rb[Z] of the opcode's fields Y = (Op >> 3)&7 and Z = Op&7,
+//	%p, %q	the register pair Rw[Y >> 1], with SP or with AF,
+//	%c, %k	the condition Cc[Y] or Cc[Y&3],
+//	%a, %s	the arithmetic or shift operator of Y, padded to the operand column,
+//	%n, %r	the bit number Y or the restart address Op&070,
+//	%x, %d	the index register and the signed displacement,
+//	%b, %w	the immediate byte or word,
+//	%t, %j	the absolute or PC-relative target of a jump,
+//	%o	the opcode byte itself.
+
+// The operand formats.
+enum FormT {
+   FmNone,	// No operand.
+   FmB,		// An immediate byte.
+   FmW,		// An immediate word or an address.
+   FmJ,		// A PC-relative jump target.
+   FmD,		// An index displacement.
+   FmDB,	// An index displacement, then an immediate byte.
+   FmPre,	// A prefix: the next byte is an opcode of the page Next.
+   FmPreD,	// A prefix: the next byte is a displacement, then comes an opcode of the page Next.
+   FmFall,	// The prefix does not apply: the opcode is decoded as in the base page.
+   FmBad	// Not an opcode of the processor: it is left as data.
+};
+
+// The flow kinds.
+enum FlowT {
+   FlNone,	// To the next opcode.
+   FlJump,	// To the target only: jp Aw; jr Js.
+   FlBranch,	// To the target or the next opcode: jp Cc,Aw; jr Cc,Js; djnz Js.
+   FlCall,	// To the target, then the next opcode: call [Cc,]Aw.
+   FlRst,	// To the restart address, then the next opcode: rst n.
+   FlRet,	// Back to the caller: ret; reti; retn.
+   FlCondRet,	// Back to the caller or to the next opcode: ret Cc.
+   FlJumpInd	// To a computed address: jp (HL); jp (IX); jp (IY).
+};
+
+// The opcode pages; with -cpu, the base page is that of the 8080 or 8085, in Intel mnemonics, and there are no prefixes.
+enum PageT { PgBase, PgCB, PgED, PgDD, PgFD, PgDDCB, PgFDCB, Pg8080, Pg8085, PageN };
+
+struct OpInfo {
+   const char *Text;	// The template for the text.
+   uint8_t Form;	// The operand format (FormT).
+   uint8_t Len;		// The number of operand bytes after the opcode.
+   uint8_t Flow;	// The flow kind (FlowT).
+   uint8_t Next;	// The page after a prefix (PageT).
+};
+
+struct OpPage { OpInfo Op[0x100]; };
+
+constexpr uint8_t FormLen(int Form) { return Form == FmW || Form == FmDB? 2: Form == FmB || Form == FmJ || Form == FmD? 1: 0; }
+
+constexpr OpInfo Entry(const char *Text, int Form = FmNone, int Flow = FlNone, int Next = PgBase) {
+   return OpInfo{ Text, uint8_t(Form), FormLen(Form), uint8_t(Flow), uint8_t(Next) };
+}
+
+constexpr const char *S0Ops[8] = { "RLCA", "RRCA", "RLA", "RRA", "DAA", "CPL", "SCF", "CCF" };
+constexpr const char *BOps[4][4] = {
+   { "LDI", "LDD", "LDIR", "LDDR" },
+   { "CPI", "CPD", "CPIR", "CPDR" },
+   { "INI", "IND", "INIR", "INDR" },
+   { "OUTI", "OUTD", "OTIR", "OTDR" }
+};
+
+constexpr OpInfo BaseOp(int Op) {
+   int X = Op >> 6, Y = (Op >> 3)&7, Z = Op&7;
+   switch (X) {
+      case 0: switch (Z) {
+         case 0: switch (Y) {
+            case 0: return Entry("NOP");
+            case 1: return Entry("EX      AF,AF'");
+            case 2: return Entry("DJNZ    %j", FmJ, FlBranch);
+            case 3: return Entry("JR      %j", FmJ, FlJump);
+            default: return Entry("JR      %k,%j", FmJ, FlBranch);
+         }
+         case 1: return Y&1? Entry("ADD     HL,%p"): Entry("LD      %p,%w", FmW);
+         case 2: switch (Y) {
+            case 0: return Entry("LD      (BC),A");
+            case 1: return Entry("LD      A,(BC)");
+            case 2: return Entry("LD      (DE),A");
+            case 3: return Entry("LD      A,(DE)");
+            case 4: return Entry("LD      (%w),HL", FmW);
+            case 5: return Entry("LD      HL,(%w)", FmW);
+            case 6: return Entry("LD      (%w),A", FmW);
+            default: return Entry("LD      A,(%w)", FmW);
+         }
+         case 3: return Y&1? Entry("DEC     %p"): Entry("INC     %p");
+         case 4: return Entry("INC     %y");
+         case 5: return Entry("DEC     %y");
+         case 6: return Entry("LD      %y,%b", FmB);
+         default: return Entry(S0Ops[Y]);
+      }
+   // ld Rd,Rs or halt.
+      case 1: return Op == 0166? Entry("HALT"): Entry("LD      %y,%z");
+      case 2: return Entry("%a%z");
+      default: switch (Z) {
+         case 0: return Entry("RET     %c", FmNone, FlCondRet);
+         case 1: switch (Y) {
+            case 1: return Entry("RET", FmNone, FlRet);
+            case 3: return Entry("EXX");
+            case 5: return Entry("JP      (HL)", FmNone, FlJumpInd);
+            case 7: return Entry("LD      SP,HL");
+            default: return Entry("POP     %q");
+         }
+         case 2: return Entry("JP      %c,%t", FmW, FlBranch);
+         case 3: switch (Y) {
+            case 0: return Entry("JP      %t", FmW, FlJump);
+            case 1: return Entry("", FmPre, FlNone, PgCB);
+            case 2: return Entry("OUT     (%b),A", FmB);
+            case 3: return Entry("IN      A,(%b)", FmB);
+            case 4: return Entry("EX      (SP),HL");
+            case 5: return Entry("EX      DE,HL");
+            case 6: return Entry("DI");
+            default: return Entry("EI");
+         }
+         case 4: return Entry("CALL    %c,%t", FmW, FlCall);
+         case 5: switch (Y) {
+            case 1: return Entry("CALL    %t", FmW, FlCall);
+            case 3: return Entry("", FmPre, FlNone, PgDD);
+            case 5: return Entry("", FmPre, FlNone, PgED);
+            case 7: return Entry("", FmPre, FlNone, PgFD);
+            default: return Entry("PUSH    %q");
+         }
+         case 6: return Entry("%a%b", FmB);
+         default: return Entry("RST     %r", FmNone, FlRst);
+      }
+   }
+}
+
+constexpr OpInfo CBOp(int Op) {
+   switch (Op >> 6) {
+      case 0: return Entry("%s%z");
+      case 1: return Entry("BIT     %n,%z");
+      case 2: return Entry("RES     %n,%z");
+      default: return Entry("SET     %n,%z");
+   }
+}
+
+constexpr OpInfo EDOp(int Op) {
+   int X = Op >> 6, Y = (Op >> 3)&7, Z = Op&7;
+// Undocumented: all the opcodes not listed are "nop".
+   if (X == 2) return Z < 4 && Y >= 4? Entry(BOps[Z][Y&3]): Entry("NOP");
+   if (X != 1) return Entry("NOP");
+   switch (Z) {
+   // Undocumented: "in (C)" sets the flags, but does not modify a register.
+      case 0: return Y == 6? Entry("IN      (C)"): Entry("IN      %y,(C)");
+   // Undocumented: "out (C),0" outputs 0.
+      case 1: return Y == 6? Entry("OUT     (C),0"): Entry("OUT     (C),%y");
+      case 2: return Y&1? Entry("ADC     HL,%p"): Entry("SBC     HL,%p");
+      case 3: return Y&1? Entry("LD      %p,(%w)", FmW): Entry("LD      (%w),%p", FmW);
+   // Undocumented: the other cases are also "neg".
+      case 4: return Entry("NEG");
+   // Undocumented: the other cases are also "retn".
+      case 5: return Y == 1? Entry("RETI", FmNone, Op == 0115? FlRet: FlNone): Entry("RETN", FmNone, Op == 0105? FlRet: FlNone);
+      case 6: switch (Y&3) {
+         case 0: return Entry("IM      0");
+         case 1: return Entry("IM      0/1");
+         case 2: return Entry("IM      1");
+         default: return Entry("IM      2");
+      }
+      default: switch (Y) {
+         case 0: return Entry("LD      I,A");
+         case 1: return Entry("LD      R,A");
+         case 2: return Entry("LD      A,I");
+         case 3: return Entry("LD      A,R");
+         case 4: return Entry("RRD");
+         case 5: return Entry("RLD");
+         default: return Entry("NOP");
+      }
+   }
+}
+
+// 335: IX, 375: IY; Next is the page after 0313.
+constexpr OpInfo IndexOp(int Op, int Next) {
+   int Y = (Op >> 3)&7, Z = Op&7;
+   switch (Op) {
+      case 0011: return Entry("ADD     %x,BC");
+      case 0031: return Entry("ADD     %x,DE");
+      case 0051: return Entry("ADD     %x,%x");
+      case 0071: return Entry("ADD     %x,SP");
+      case 0041: return Entry("LD      %x,%w", FmW);
+      case 0042: return Entry("LD      (%w),%x", FmW);
+      case 0052: return Entry("LD      %x,(%w)", FmW);
+      case 0043: return Entry("INC     %x");
+      case 0053: return Entry("DEC     %x");
+      case 0044: return Entry("INC     %xH");
+      case 0045: return Entry("DEC     %xH");
+      case 0046: return Entry("LD      %xH,%b", FmB);
+      case 0054: return Entry("INC     %xL");
+      case 0055: return Entry("DEC     %xL");
+      case 0056: return Entry("LD      %xL,%b", FmB);
+      case 0064: return Entry("INC     (%x%d)", FmD);
+      case 0065: return Entry("DEC     (%x%d)", FmD);
+      case 0066: return Entry("LD      (%x%d),%b", FmDB);
+      case 0341: return Entry("POP     %x");
+      case 0343: return Entry("EX      (SP),%x");
+      case 0345: return Entry("PUSH    %x");
+      case 0351: return Entry("JP      (%x)", FmNone, FlJumpInd);
+      case 0371: return Entry("LD      SP,%x");
+      case 0313: return Entry("", FmPreD, FlNone, Next);
+   }
+   switch (Op >> 6) {
+      case 1:
+         if (Op == 0166) break;
+         if (Y == 6) return Entry("LD      (%x%d),%z", FmD);
+         if (Z == 6) return Entry("LD      %y,(%x%d)", FmD);
+         if (Y == 4 || Y == 5) return Z == 4? Entry("LD      %x%y,%xH"): Z == 5? Entry("LD      %x%y,%xL"): Y == 4? Entry("LD      %xH,%z"): Entry("LD      %xL,%z");
+         if (Z == 4) return Entry("LD      %y,%xH");
+         if (Z == 5) return Entry("LD      %y,%xL");
       break;
-   // ld BC,Dw; ld DE,Dw; ld HL,Dw; ld SP,(Dw)
-      case 0001: case 0021: case 0041: case 0061:
-   // ld (Aw),HL; ld HL,(Aw); ld (Aw),A; ld A,(Aw)
-      case 0042: case 0052: case 0062: case 0072:
-   // jp Cc,Js; [Cc: nz; z; nc; c; po; pe; p; m]
-      case 0302: case 0312: case 0322: case 0332: case 0342: case 0352: case 0362: case 0372:
-   // jp Aw; call Aw
-      case 0303: case 0315:
-   // call Cc,Js; [Cc: nz; z; nc; c; po; pe; p; m]
-      case 0304: case 0314: case 0324: case 0334: case 0344: case 0354: case 0364: case 0374:
-         IP += 2;
+      case 2:
+         if (Z == 4) return Entry("%a%xH");
+         if (Z == 5) return Entry("%a%xL");
+         if (Z == 6) return Entry("%a(%x%d)", FmD);
       break;
-   // Indexed Operations [Rx: IX; IY].
-      case 0335: case 0375: switch (GetB(IP)) { // The secondary opcode.
-      // IOp (Rx+Ds); [IOp: inc; dec]
-         case 0064: case 0065:
-      // ld Rd,(Rx+Ds); [Rd: B; C; D; E; H; L; A]
-         case 0106: case 0116: case 0126: case 0136: case 0146: case 0156: case 0176:
-      // ld (Rx+Ds),Rs; [Rs: B; C; D; E; H; L; A]
-         case 0160: case 0161: case 0162: case 0163: case 0164: case 0165: case 0167:
-      // AOp (Rx+Ds); [AOp: add A,; adc A,; sub A,; sbc A,; and; xor; or; cp]
-         case 0206: case 0216: case 0226: case 0236: case 0246: case 0256: case 0266: case 0276:
-            IP++;
-         break;
-      // ld (Rx+Ds),Db
-         case 0066:
-      // Rotation,Bit-Op (Rx+Ds).
-         case 0313:
-            IP += 2;
-         break;
-      // All other cases, both official and unofficial, match the main opcode table.
-         default: IP--; goto MainOp;
+   }
+// All other cases, both official and unofficial, match the main opcode table.
+   return Entry("", FmFall);
+}
+
+// 335 313 Ds: IX, 375 313 Ds: IY.
+// Undocumented: with Z ≠ 6, the result is also copied to the register Rb[Z]; bit is the same as with Z = 6.
+constexpr OpInfo IndexCBOp(int Op) {
+   bool Copy = (Op&7) != 6;
+   switch (Op >> 6) {
+      case 0: return Copy? Entry("%s(%x%d),%z"): Entry("%s(%x%d)");
+      case 1: return Entry("BIT     %n,(%x%d)");
+      case 2: return Copy? Entry("RES     %n,(%x%d),%z"): Entry("RES     %n,(%x%d)");
+      default: return Copy? Entry("SET     %n,(%x%d),%z"): Entry("SET     %n,(%x%d)");
+   }
+}
+
+// The 8080 and the 8085.
+// Their opcodes are those of the Z80 base page, but for the relative jumps, the exchanges with the alternate registers and the prefixes,
+// which the 8080 leaves as data; the 8085 has ‟RIM” and ‟SIM” and the undocumented opcodes (‟DSUB”, ‟LHLX” and the like) in their place.
+// ‟RSTV”, a restart to 0x40 on overflow, is not followed.
+constexpr const char *IS0Ops[8] = { "RLC", "RRC", "RAL", "RAR", "DAA", "CMA", "STC", "CMC" };
+constexpr const char *IS8085Ops[8] = { "NOP", "DSUB", "ARHL", "RDEL", "RIM", "LDHI    %b", "SIM", "LDSI    %b" };
+constexpr const char *IAOps[8] = { "ADD     %z", "ADC     %z", "SUB     %z", "SBB     %z", "ANA     %z", "XRA     %z", "ORA     %z", "CMP     %z" };
+constexpr const char *IAImm[8] = { "ADI     %b", "ACI     %b", "SUI     %b", "SBI     %b", "ANI     %b", "XRI     %b", "ORI     %b", "CPI     %b" };
+constexpr const char *IRcc[8] = { "RNZ", "RZ", "RNC", "RC", "RPO", "RPE", "RP", "RM" };
+constexpr const char *IJcc[8] = { "JNZ     %t", "JZ      %t", "JNC     %t", "JC      %t", "JPO     %t", "JPE     %t", "JP      %t", "JM      %t" };
+constexpr const char *ICcc[8] = { "CNZ     %t", "CZ      %t", "CNC     %t", "CC      %t", "CPO     %t", "CPE     %t", "CP      %t", "CM      %t" };
+
+constexpr OpInfo IntelOp(int Op, bool Is85) {
+   int X = Op >> 6, Y = (Op >> 3)&7, Z = Op&7;
+   const OpInfo Bad = Entry("DEFB    %o", FmBad);
+   switch (X) {
+      case 0: switch (Z) {
+         case 0: return Y == 0? Entry("NOP"): !Is85? Bad: Y == 5 || Y == 7? Entry(IS8085Ops[Y], FmB): Entry(IS8085Ops[Y]);
+         case 1: return Y&1? Entry("DAD     %p"): Entry("LXI     %p,%w", FmW);
+         case 2: switch (Y) {
+            case 0: return Entry("STAX    B");
+            case 1: return Entry("LDAX    B");
+            case 2: return Entry("STAX    D");
+            case 3: return Entry("LDAX    D");
+            case 4: return Entry("SHLD    %w", FmW);
+            case 5: return Entry("LHLD    %w", FmW);
+            case 6: return Entry("STA     %w", FmW);
+            default: return Entry("LDA     %w", FmW);
+         }
+         case 3: return Y&1? Entry("DCX     %p"): Entry("INX     %p");
+         case 4: return Entry("INR     %y");
+         case 5: return Entry("DCR     %y");
+         case 6: return Entry("MVI     %y,%b", FmB);
+         default: return Entry(IS0Ops[Y]);
       }
-      break;
-      case 0355: switch (GetB(IP)) { // The secondary opcode.
-      // ld (Aw),BC; ld (Aw),DE; ld (Aw),HL; ld (Aw),SP
-         case 0103: case 0123: case 0143: case 0163:
-      // ld BC,(Aw); ld DE,(Aw); ld HL,(Aw); ld SP,(Aw)
-         case 0113: case 0133: case 0153: case 0173:
-            IP += 2;
-         break;
+      case 1: return Op == 0166? Entry("HLT"): Entry("MOV     %y,%z");
+      case 2: return Entry(IAOps[Y]);
+      default: switch (Z) {
+         case 0: return Entry(IRcc[Y], FmNone, FlCondRet);
+         case 1: switch (Y) {
+            case 1: return Entry("RET", FmNone, FlRet);
+            case 3: return Is85? Entry("SHLX"): Bad;
+            case 5: return Entry("PCHL", FmNone, FlJumpInd);
+            case 7: return Entry("SPHL");
+            default: return Entry("POP     %q");
+         }
+         case 2: return Entry(IJcc[Y], FmW, FlBranch);
+         case 3: switch (Y) {
+            case 0: return Entry("JMP     %t", FmW, FlJump);
+            case 1: return Is85? Entry("RSTV"): Bad;
+            case 2: return Entry("OUT     %b", FmB);
+            case 3: return Entry("IN      %b", FmB);
+            case 4: return Entry("XTHL");
+            case 5: return Entry("XCHG");
+            case 6: return Entry("DI");
+            default: return Entry("EI");
+         }
+         case 4: return Entry(ICcc[Y], FmW, FlCall);
+         case 5: switch (Y) {
+            case 1: return Entry("CALL    %t", FmW, FlCall);
+            case 3: return Is85? Entry("JNK     %t", FmW, FlBranch): Bad;
+            case 5: return Is85? Entry("LHLX"): Bad;
+            case 7: return Is85? Entry("JK      %t", FmW, FlBranch): Bad;
+            default: return Entry("PUSH    %q");
+         }
+         case 6: return Entry(IAImm[Y], FmB);
+         default: return Entry("RST     %n", FmNone, FlRst);
+      }
+   }
+}
+
+constexpr OpInfo PageOp(int Page, int Op) {
+   switch (Page) {
+      case PgBase: return BaseOp(Op);
+      case Pg8080: return IntelOp(Op, false);
+      case Pg8085: return IntelOp(Op, true);
+      case PgCB: return CBOp(Op);
+      case PgED: return EDOp(Op);
+      case PgDD: return IndexOp(Op, PgDDCB);
+      case PgFD: return IndexOp(Op, PgFDCB);
+      default: return IndexCBOp(Op);
+   }
+}
+
+constexpr OpPage MakePage(int Page) {
+   OpPage P{};
+   for (int Op = 0; Op < 0x100; Op++) P.Op[Op] = PageOp(Page, Op);
+   return P;
+}
+
+static constexpr OpPage Pages[PageN] = {
+   MakePage(PgBase), MakePage(PgCB), MakePage(PgED), MakePage(PgDD), MakePage(PgFD), MakePage(PgDDCB), MakePage(PgFDCB), MakePage(Pg8080), MakePage(Pg8085)
+};
+
+// The page of the base opcodes: PgBase, or Pg8080 or Pg8085 with -cpu.
+// The opcodes decoded from it are cached as those of PgBase, so the analyses see the opcodes that the 8080 and 8085 share with the Z80 as they are on the Z80.
+static uint8_t BasePg = PgBase;
+
+// The T-states of the opcodes, in tables that parallel the opcode tables, with the prefixes of each page included:
+// T, or, for a conditional opcode or a repeated block opcode, T when it jumps or repeats and TNot when it does not.
+struct OpTime { uint8_t T, TNot; };
+struct TimePage { OpTime Op[0x100]; };
+
+constexpr OpTime Time(int T, int TNot = -1) { return OpTime{ uint8_t(T), uint8_t(TNot < 0? T: TNot) }; }
+
+constexpr OpTime BaseTime(int Op) {
+   int X = Op >> 6, Y = (Op >> 3)&7, Z = Op&7;
+   switch (X) {
+      case 0: switch (Z) {
+         case 0: return Y == 2? Time(13, 8): Y == 3? Time(12): Y > 3? Time(12, 7): Time(4);
+         case 1: return Time(Y&1? 11: 10);
+         case 2: return Time(Y < 4? 7: Y < 6? 16: 13);
+         case 3: return Time(6);
+         case 4: case 5: return Time(Y == 6? 11: 4);
+         case 6: return Time(Y == 6? 10: 7);
+         default: return Time(4);
+      }
+      case 1: return Time(Op != 0166 && (Y == 6 || Z == 6)? 7: 4);
+      case 2: return Time(Z == 6? 7: 4);
+      default: switch (Z) {
+         case 0: return Time(11, 5);
+         case 1: return Time(Y == 1? 10: Y == 3 || Y == 5? 4: Y == 7? 6: 10);
+         case 2: return Time(10);
+         case 3: return Time(Y == 0? 10: Y == 2 || Y == 3? 11: Y == 4? 19: Y == 1? 0: 4);
+         case 4: return Time(17, 10);
+         case 5: return Time(Y == 1? 17: Y&1? 0: 11);
+         case 6: return Time(7);
+         default: return Time(11);
       }
-      break;
    }
-   return IP - IP0;
 }
 
-static void OpScan(uint16_t IP) {
+constexpr OpTime CBTime(int Op) { return Time((Op&7) != 6? 8: Op >> 6 == 1? 12: 15); }
+
+constexpr OpTime EDTime(int Op) {
+   int X = Op >> 6, Y = (Op >> 3)&7, Z = Op&7;
+   if (X == 2) return Z < 4 && Y >= 6? Time(21, 16): Z < 4 && Y >= 4? Time(16): Time(8);
+   if (X != 1) return Time(8);
+   switch (Z) {
+      case 0: case 1: return Time(12);
+      case 2: return Time(15);
+      case 3: return Time(20);
+      case 5: return Time(14);
+      case 7: return Time(Y < 4? 9: Y < 6? 18: 8);
+      default: return Time(8);
+   }
+}
+
+// The opcodes on (HL) take (IX+d) instead; the others take 4 more T-states, for the prefix, than in the base page.
+constexpr OpTime IndexTime(int Op) {
+   int X = Op >> 6, Y = (Op >> 3)&7, Z = Op&7;
+   if (Op == 0064 || Op == 0065 || Op == 0343) return Time(23);
+   if (Op == 0066 || X == 1 && Op != 0166 && (Y == 6) != (Z == 6) || X == 2 && Z == 6) return Time(19);
+   return Time(BaseTime(Op).T + 4, BaseTime(Op).TNot + 4);
+}
+
+constexpr OpTime IndexCBTime(int Op) { return Time(Op >> 6 == 1? 20: 23); }
+
+// The states of the 8080 and the 8085, as the T-states of the Z80.
+constexpr OpTime IntelTime(int Op, bool Is85) {
+   int X = Op >> 6, Y = (Op >> 3)&7, Z = Op&7;
+   switch (X) {
+      case 0: switch (Z) {
+         case 0: return Time(!Is85 || Y == 0 || Y == 4 || Y == 6? 4: Y == 2? 7: 10);
+         case 1: return Time(10);
+         case 2: return Time(Y < 4? 7: Y < 6? 16: 13);
+         case 3: return Time(Is85? 6: 5);
+         case 4: case 5: return Time(Y == 6? 10: Is85? 4: 5);
+         case 6: return Time(Y == 6? 10: 7);
+         default: return Time(4);
+      }
+      case 1: return Time(Op == 0166? (Is85? 5: 7): Y == 6 || Z == 6? 7: Is85? 4: 5);
+      case 2: return Time(Z == 6? 7: 4);
+      default: switch (Z) {
+         case 0: return Is85? Time(12, 6): Time(11, 5);
+         case 1: return Time(Y == 5 || Y == 7? (Is85? 6: 5): 10);
+         case 2: return Time(10, 7);
+         case 3: return Y == 1? (Is85? Time(12, 6): Time(4)): Time(Y == 0 || Y == 2 || Y == 3? 10: Y == 4? (Is85? 16: 18): Y == 5? (Is85? 4: 5): 4);
+         case 4: return Is85? Time(18, 9): Time(17, 11);
+         case 5: return Y == 1? Time(Is85? 18: 17): Is85 && (Y == 3 || Y == 7)? Time(10, 7): Is85 && Y == 5? Time(10): Time(Is85? 12: 11);
+         case 6: return Time(7);
+         default: return Time(Is85? 12: 11);
+      }
+   }
+}
+
+constexpr TimePage MakeTimes(int Page) {
+   TimePage P{};
+   for (int Op = 0; Op < 0x100; Op++)
+      P.Op[Op] = Page == PgBase? BaseTime(Op): Page == PgCB? CBTime(Op): Page == PgED? EDTime(Op): Page == PgDD || Page == PgFD? IndexTime(Op):
+         Page == Pg8080 || Page == Pg8085? IntelTime(Op, Page == Pg8085): IndexCBTime(Op);
+   return P;
+}
+
+static constexpr TimePage Times[PageN] = {
+   MakeTimes(PgBase), MakeTimes(PgCB), MakeTimes(PgED), MakeTimes(PgDD), MakeTimes(PgFD), MakeTimes(PgDDCB), MakeTimes(PgFDCB), MakeTimes(Pg8080), MakeTimes(Pg8085)
+};
+
+// The decoded-opcode cache.
+// ─────────────────────────
+// Each opcode is decoded only once, the first time it is needed, into parallel arrays indexed by its address, like Mode[].
+// The flow analysis and the output both read it from there, as should any later analysis.
+static uint8_t *DcLen;		// The length of the opcode, with the prefixes and operands, or 0 if it is not yet decoded.
+static uint16_t *DcOp;		// Its class: the page and the last opcode byte, Page << 8 | Op.
+static uint16_t *DcImm;		// The immediate operand, or the target of a jump.
+static int8_t *DcDs;		// The index displacement.
+static uint8_t *DcFlags;	// The flow kind (FlowT) in bits 0-2, and DcIY.
+static const uint8_t DcFlow = 0x07, DcIY = 0x08;
+
+// A view of the 64K address space: the code, its modes and its decoded opcodes.
+// There is one for a plain image and one for each bank of a banked image, allocated as the bank is reached.
+struct View {
+   uint8_t Code[CodeMax], Mode[CodeMax];
+   uint8_t DcLen[CodeMax]; uint16_t DcOp[CodeMax], DcImm[CodeMax]; int8_t DcDs[CodeMax]; uint8_t DcFlags[CodeMax];
+};
+
+// Make a new view, with all of its memory filled with Fill, the current one.
+static View *NewView(int Fill) {
+   View *V = (View *)malloc(sizeof *V); if (V == nullptr) exit(1);
+   memset(V->Code, Fill, CodeMax), memset(V->Mode, Empty, CodeMax), memset(V->DcLen, 0, CodeMax);
+   Code = V->Code, Mode = V->Mode, DcLen = V->DcLen, DcOp = V->DcOp, DcImm = V->DcImm, DcDs = V->DcDs, DcFlags = V->DcFlags;
+   return V;
+}
+
+// The table entry of a decoded opcode.
+static inline const OpInfo &DcInfo(uint16_t IP) { unsigned Page = DcOp[IP] >> 8; return Pages[Page == PgBase? BasePg: Page].Op[DcOp[IP]&0xff]; }
+
+// The timing entry of a decoded opcode.
+static inline const OpTime &DcTimes(uint16_t IP) { unsigned Page = DcOp[IP] >> 8; return Times[Page == PgBase? BasePg: Page].Op[DcOp[IP]&0xff]; }
+
+// The T-states of a decoded opcode, when it jumps or repeats (Taken) or not, with 4 more for each prefix that does not apply.
+static inline unsigned DcTime(uint16_t IP, bool Taken) {
+   static const uint8_t PageLen[PageN] = { 1, 2, 2, 2, 2, 4, 4, 1, 1 };
+   unsigned Page = DcOp[IP] >> 8; const OpTime &T = DcTimes(IP);
+   return (Taken? T.T: T.TNot) + 4*(DcLen[IP] - PageLen[Page] - DcInfo(IP).Len);
+}
+
+// Decode the opcode at IP into the cache, if it is not already there; return its length.
+static int Decode(uint16_t IP) {
+   if (DcLen[IP] != 0) return DcLen[IP];
+   uint16_t IP0 = IP;
+   int Page = BasePg; int16_t Ds = 0; uint16_t Imm = 0;
+   while (true) {
+      uint8_t Op = GetB(IP);
+      const OpInfo *Info = &Pages[Page].Op[Op];
+      int InPage = Page;
+      if (Info->Form == FmFall) Info = &Pages[InPage = PgBase].Op[Op];
+      switch (Info->Form) {
+         case FmPre: Page = Info->Next; continue;
+         case FmPreD: Page = Info->Next, Ds = GetDs(IP); continue;
+         case FmB: Imm = GetB(IP); break;
+         case FmW: Imm = GetW(IP); break;
+         case FmJ: Imm = GetJs(IP); break;
+         case FmD: Ds = GetDs(IP); break;
+         case FmDB: Ds = GetDs(IP), Imm = GetB(IP); break;
+      }
+      DcOp[IP0] = (InPage == BasePg? PgBase: InPage) << 8 | Op, DcImm[IP0] = Imm, DcDs[IP0] = Ds;
+      DcFlags[IP0] = Info->Flow | (Page == PgFD || Page == PgFDCB? DcIY: 0);
+      return DcLen[IP0] = uint8_t(IP - IP0);
+   }
+}
+
+// Jump tables.
+// ────────────
+// While following a path, OpScan() tracks what is known of the registers, so that an indirect jump through a dispatch table can be resolved.
+// A value is known as an index Base + Scale·i, for 0 ≤ i < N (a constant, for N = 1), or as the byte or word read from a table at such an index.
+// The bound N comes from a range check: ‟CP n” followed by ‟JR NC” or ‟JP NC” away from the path (or ‟RET NC”), or by ‟JR C” or ‟JP C” onto it,
+// or from a mask ‟AND 2ᵏ-1”.
+// So, for instance, in
+//	CP 5; JR NC,Bad; ADD A,A; LD L,A; LD H,0; LD DE,Table; ADD HL,DE; LD A,(HL); INC HL; LD H,(HL); LD L,A; JP (HL)
+// HL is left as the word at Table + 2·i, for 0 ≤ i < 5: each of the 5 words is scanned as code and the table is output as ‟DEFW” data.
+// A jump to an index itself, as into a table of ‟JP” opcodes, scans each of its addresses as code.
+// Any opcode not modeled makes the registers that it changes unknown; a call makes all of them unknown.
+enum ValKind { VUnknown, VIndex, VByte, VWord };
+struct Val {
+   uint8_t Kind;	// The kind of value (ValKind).
+   uint8_t Scale;	// The stride of the index i.
+   uint16_t Base;	// The value, or the address read, at i = 0.
+   uint16_t N;		// The number of values of i.
+};
+
+enum { RwBC, RwDE, RwHL, RwIX, RwIY, RwN };
+static const int RegA = 7;
+
+struct RegState {
+   Val R[8];		// The 8-bit registers, in the order of Rb[]; R[6], for (HL), is not used.
+   Val W[RwN];		// The register pairs, if known as a whole; this takes precedence over their halves.
+   uint16_t Cmp;	// The operand n of a ‟CP n”, whose flags and A are still live, or 0.
+};
+
+static inline Val Unknown(void) { return Val{ VUnknown, 0, 0, 0 }; }
+static inline Val Const(uint16_t C) { return Val{ VIndex, 0, C, 1 }; }
+static inline bool IsConst(const Val &V) { return V.Kind == VIndex && V.N == 1; }
+
+// Base + Scale·i, for 0 ≤ i < N, if it never exceeds Max.
+static Val Index(uint32_t Base, uint32_t Scale, uint32_t N, uint32_t Max) {
+   if (N == 0) return Unknown();
+   if (N == 1) Scale = 0;
+   if (Scale > 0xff || Base + Scale*(N - 1) > Max) return Unknown();
+   return Val{ VIndex, uint8_t(Scale), uint16_t(Base), uint16_t(N) };
+}
+
+// A + B, where at least one of the two is a constant.
+static Val AddVal(const Val &A, const Val &B, uint32_t Max) {
+   if (A.Kind != VIndex || B.Kind != VIndex || A.N > 1 && B.N > 1) return Unknown();
+   return A.N > 1? Index(A.Base + B.Base, A.Scale, A.N, Max): Index(A.Base + B.Base, B.Scale, B.N, Max);
+}
+
+static Val Offset(const Val &V, int D, uint32_t Max) {
+   if (V.Kind != VIndex || int(V.Base) + D < 0) return Unknown();
+   return Index(V.Base + D, V.Scale, V.N, Max);
+}
+
+static Val Double(const Val &V, uint32_t Max) { return V.Kind != VIndex? Unknown(): Index(2*V.Base, 2*V.Scale, V.N, Max); }
+
+// and N: if N = 2ᵏ - 1, then 0 ≤ A ≤ N.
+static Val Mask(const Val &A, uint32_t N) {
+   if (N&(N + 1)) return Unknown();
+   if (A.Kind == VIndex && A.N > 0 && uint32_t(A.Base) + uint32_t(A.Scale)*(A.N - 1U) <= N) return A;
+   return Index(0, 1, N + 1, 0xff);
+}
+
+// The byte read from the address V.
+static Val LoadByte(const Val &V) { return V.Kind != VIndex? Unknown(): Val{ VByte, V.Scale, V.Base, V.N }; }
+
+static Val GetPair(const RegState &S, int P) {
+   if (S.W[P].Kind != VUnknown || P > RwHL) return S.W[P];
+   const Val &Hi = S.R[2*P], &Lo = S.R[2*P + 1];
+   if (IsConst(Hi) && Lo.Kind == VIndex) return Index(Hi.Base << 8 | Lo.Base, Lo.Scale, Lo.N, 0xffff);
+   if (Hi.Kind == VByte && Lo.Kind == VByte && Hi.Base == uint16_t(Lo.Base + 1) && Hi.Scale == Lo.Scale && Hi.N == Lo.N)
+      return Val{ VWord, Lo.Scale, Lo.Base, Lo.N };
+   return Unknown();
+}
+
+static void SetPair(RegState &S, int P, const Val &V) {
+   S.W[P] = V;
+   if (P <= RwHL) S.R[2*P] = IsConst(V)? Const(V.Base >> 8): Unknown(), S.R[2*P + 1] = IsConst(V)? Const(V.Base&0xff): Unknown();
+}
+
+static void SetReg(RegState &S, int R, const Val &V) {
+   if (R == 6) return; // A store to (HL).
+   S.R[R] = V;
+   if (R == RegA) S.Cmp = 0; else S.W[R >> 1] = Unknown();
+}
+
+// add HL,Rw[Y >> 1] (or IX, IY, for P): with Y >> 1 = 2 meaning P itself.
+static void AddPair(RegState &S, int P, int Y) {
+   int Q = Y >> 1; Val D = GetPair(S, P);
+   SetPair(S, P, Q == 2? Double(D, 0xffff): Q == 3? Unknown(): AddVal(D, GetPair(S, Q), 0xffff)), S.Cmp = 0;
+}
+
+// A range check has passed: A < N.
+static void Bound(RegState &S, uint32_t N) {
+   Val &A = S.R[RegA];
+   if (A.Kind == VUnknown) A = Index(0, 1, N, 0xff);
+   else if (A.Kind == VIndex && A.Base == 0 && A.Scale == 1 && A.N > N) A.N = N;
+}
+
+// The condition of a conditional jump or return at IP, as an index into Cc[], or -1.
+static int Cond(uint16_t IP) {
+   int Op = DcOp[IP]; // Only the base page: PgBase = 0.
+   if (Op >= 0x100) return -1;
+   if ((Op&0307) == 0300 || (Op&0307) == 0302 || (Op&0307) == 0304) return (Op >> 3)&7;
+   if ((Op&0347) == 0040) return (Op >> 3)&3;
+   return -1;
+}
+
+// Update the register state S past the decoded opcode at IP.
+static void Track(RegState &S, uint16_t IP) {
+   int Page = DcOp[IP] >> 8, Op = DcOp[IP]&0xff, X = Op >> 6, Y = (Op >> 3)&7, Z = Op&7;
+   uint16_t Imm = DcImm[IP];
+   const Val &A = S.R[RegA];
+// The opcodes of the 8085 that are not those of the Z80 at the same codes (‟DSUB”, ‟LHLX” and the like) leave the registers unknown.
+   if (BasePg == Pg8085 && Page == PgBase && (X == 0 && Z == 0 && Y != 0 || Op == 0313 || Op == 0331 || Op == 0335 || Op == 0355 || Op == 0375)) {
+      for (int R = 0; R < 8; R++) S.R[R] = Unknown();
+      for (int P = RwBC; P <= RwHL; P++) S.W[P] = Unknown();
+      S.Cmp = 0;
+      return;
+   }
+   switch (Page) {
+      case PgCB:
+      // sla A
+         if (Op == 0047) { SetReg(S, RegA, Double(A, 0xff)); return; }
+      // Fall through.
+      case PgDDCB: case PgFDCB:
+      // The shifts set the carry; bit leaves the registers alone.
+         if (X == 0) S.Cmp = 0;
+         if (X != 1 && Z != 6) SetReg(S, Z, Unknown());
+      return;
+      case PgED:
+      // The stores, outputs, interrupt modes and returns, and ‟ld I,A”, ‟ld R,A” leave the registers alone.
+         if (X == 0 || X == 3 || X == 1 && (Z == 1 || Z == 5 || Z == 6 || Z == 3 && !(Y&1) || Z == 7 && Y < 2)) return;
+         for (int R = 0; R < 8; R++) S.R[R] = Unknown();
+         for (int P = RwBC; P <= RwHL; P++) S.W[P] = Unknown();
+         S.Cmp = 0;
+      return;
+      case PgDD: case PgFD: {
+         int P = Page == PgDD? RwIX: RwIY;
+         switch (Op) {
+            case 0011: case 0031: case 0051: case 0071: AddPair(S, P, Y); return;
+            case 0041: SetPair(S, P, Const(Imm)); return;
+            case 0043: case 0053: SetPair(S, P, Offset(GetPair(S, P), Y&1? -1: +1, 0xffff)); return;
+         // Stores, pushes and ‟ld SP,IX”.
+            case 0042: case 0064: case 0065: case 0066: case 0345: case 0351: case 0371: return;
+         }
+         if (X == 1) {
+            if (Y == 6) return; // ld (IX+d),r
+            if (Z != 6 && (Y == 4 || Y == 5)) S.W[P] = Unknown(); else SetReg(S, Y, Unknown());
+         } else if (X == 2) {
+            if (Y != 7) SetReg(S, RegA, Unknown()); else S.Cmp = 0;
+         } else S.W[P] = Unknown();
+      }
+      return;
+   }
+   switch (X) {
+      case 0: switch (Z) {
+         case 0:
+            if (Y == 1) SetReg(S, RegA, Unknown()); // ex AF,AF'
+            else if (Y == 2) SetReg(S, 0, Unknown()); // djnz
+         return;
+         case 1: if (Y&1) AddPair(S, RwHL, Y); else if (Y >> 1 != 3) SetPair(S, Y >> 1, Const(Imm)); return;
+         case 2:
+            if (Y == 1 || Y == 3) SetReg(S, RegA, LoadByte(GetPair(S, Y >> 1)));
+            else if (Y == 5) SetPair(S, RwHL, Unknown());
+            else if (Y == 7) SetReg(S, RegA, Unknown());
+         return;
+         case 3: if (Y >> 1 != 3) SetPair(S, Y >> 1, Offset(GetPair(S, Y >> 1), Y&1? -1: +1, 0xffff)); return;
+      // inc r, dec r: the carry is left alone.
+         case 4: case 5: SetReg(S, Y, Offset(S.R[Y], Z == 4? +1: -1, 0xff)); return;
+         case 6: SetReg(S, Y, Const(Imm)); return;
+      // rlca doubles A, if it is below 0x80; scf and ccf change the carry.
+         default:
+            if (Y == 0) SetReg(S, RegA, Double(A, 0xff));
+            else if (Y < 6) SetReg(S, RegA, Unknown());
+            else S.Cmp = 0;
+         return;
+      }
+      case 1: if (Op != 0166) SetReg(S, Y, Z == 6? LoadByte(GetPair(S, RwHL)): S.R[Z]); return;
+      case 2:
+         if (Y == 7) S.Cmp = Z != 6 && Z != 7 && IsConst(S.R[Z])? S.R[Z].Base: 0; // cp r
+         else if (Y == 0 && Z == 7) SetReg(S, RegA, Double(A, 0xff)); // add A,A
+         else if (Y == 0 && Z != 6) SetReg(S, RegA, AddVal(A, S.R[Z], 0xff));
+         else if ((Y == 4 || Y == 6) && Z == 7) S.Cmp = 0; // and A; or A
+         else SetReg(S, RegA, Unknown());
+      return;
+      default: switch (Z) {
+         case 1:
+            if (Y == 7) SetReg(S, RegA, Unknown()); // pop AF
+            else if (!(Y&1)) SetPair(S, Y >> 1, Unknown()); // pop Rw
+            else if (Y == 3) { // exx
+               for (int R = 0; R < 6; R++) S.R[R] = Unknown();
+               for (int P = RwBC; P <= RwHL; P++) S.W[P] = Unknown();
+            }
+         return;
+         case 3: switch (Y) {
+            case 3: SetReg(S, RegA, Unknown()); return; // in A,(n)
+            case 4: SetPair(S, RwHL, Unknown()); return; // ex (SP),HL
+            case 5: { // ex DE,HL
+               Val D = S.R[2], E = S.R[3], DE = S.W[RwDE];
+               S.R[2] = S.R[4], S.R[3] = S.R[5], S.W[RwDE] = S.W[RwHL], S.R[4] = D, S.R[5] = E, S.W[RwHL] = DE;
+            }
+            return;
+         }
+         return;
+         case 6: switch (Y) {
+            case 0: SetReg(S, RegA, AddVal(A, Const(Imm), 0xff)); return;
+            case 2: SetReg(S, RegA, Offset(A, -int(Imm), 0xff)); return;
+            case 4: SetReg(S, RegA, Mask(A, Imm)); return;
+            case 7: S.Cmp = Imm; return;
+            default: SetReg(S, RegA, Unknown()); return;
+         }
+      }
+      return;
+   }
+}
+
+// Why an address is scanned as code.
+enum ScanWhy { ByStart, ByVector, ByJump, ByBranch, ByCall, ByRst, ByTable, ByGuess, BySig, ByFlow };
+static const char *WhyName[] = { "start", "vector", "jump", "branch", "call", "rst", "table", "guess", "signature", "flow" };
+
+// A pending address on the work list of OpScan().
+struct ScanItem {
+   uint16_t IP, From;	// The address and the opcode that it was reached from.
+   uint8_t Why;		// How it was reached (ScanWhy).
+   RegState Regs;	// What is known of the registers there.
+};
+// An item is pushed at most once for each opcode with two successors,
+// and the entries of a jump table are only pushed while the list is at most half full, so it never overflows.
+static ScanItem ScanList[2*CodeMax];
+
+static bool ScanQuiet = false;	// Do not report anything: OpScan() is only trying out a guess.
+static unsigned ScanClash;	// The number of collisions with other code or data, and of strays out of the image, met by OpScan().
+
+// Resolve the indirect jump at IP0 to the address V: push each of its targets onto the work list.
+// The targets of the indirect jumps resolved, for the control flow graph.
+struct TabEdge { uint16_t From, To; };
+static TabEdge *TabEdges; static uint32_t TabEdgeN, TabEdgeMax;
+
+static void JumpTable(uint16_t IP0, const Val &V, uint32_t &ScanN) {
+   bool Words = V.Kind == VWord;
+   if (!Words && V.Kind != VIndex || Words && V.Scale < 2 || V.N == 0) return;
+// The whole table has to lie in the image, in data not yet taken as code, and so do all of its targets.
+   for (uint32_t I = 0; I < V.N; I++) {
+      uint32_t Addr = V.Base + V.Scale*I, Target = Addr;
+      if (Words) {
+         if (Addr < LoRAM || Addr + 1 > HiRAM) return;
+         uint8_t M0 = Mode[Addr]&0x0f, M1 = Mode[Addr + 1]&0x0f;
+         if (!(M0 == Data && M1 == Data || M0 == Word && M1 == Operand)) return;
+         Target = Code[Addr] | Code[Addr + 1] << 8;
+      }
+      if (Target < LoRAM || Target > HiRAM) return;
+   }
+   if (ScanQuiet) ;
+   else if (Words) printf("Jump table at %4.4XH (%u words) for the jump at %4.4XH\n", V.Base, V.N, IP0);
+   else if (V.N == 1) printf("Jump to %4.4XH for the jump at %4.4XH\n", V.Base, IP0);
+   else printf("Jump vector at %4.4XH (%u addresses) for the jump at %4.4XH\n", V.Base, V.N, IP0);
+// In reverse, so that the first entry is scanned first.
+   for (uint32_t I = V.N; I-- > 0; ) {
+      uint32_t Addr = V.Base + V.Scale*I, Target = Addr;
+      if (Words) Target = Code[Addr] | Code[Addr + 1] << 8, Mode[Addr] = Word | (Mode[Addr]&0x10), Mode[Addr + 1] = Operand;
+      if (!ScanQuiet) {
+         if (TabEdgeN >= TabEdgeMax) {
+            TabEdgeMax = TabEdgeMax == 0? 0x100: 2*TabEdgeMax;
+            TabEdges = (TabEdge *)realloc(TabEdges, TabEdgeMax*sizeof *TabEdges); if (TabEdges == nullptr) exit(1);
+         }
+         TabEdges[TabEdgeN].From = IP0, TabEdges[TabEdgeN++].To = Target;
+      }
+      if (ScanN >= CodeMax) continue;
+      ScanItem &Item = ScanList[ScanN++]; Item.IP = Target, Item.From = IP0, Item.Why = ByTable, Item.Regs = RegState();
+   }
+}
+
+// Follow the program flow from IP, without recursion.
+// At a branch, the address after it is pushed and the target is scanned first; the address is popped when the path ends.
+// This visits the code in the same order as a depth-first recursion, but on a bounded list.
+// The Opcode marks in Mode[] serve as the visited map, so each byte is decoded at most once.
+static void OpScan(uint16_t IP, ScanWhy Why) {
+   uint32_t ScanN = 0;
+   uint16_t From = IP;
    bool Label = true;
+   RegState Regs = RegState();
    while (true) {
+   // A guess being tried out fails at its first clash.
+      if (ScanQuiet && ScanClash > 0) return;
+      bool End = false;
    // Mark address references to the opcode area.
       if (Label) Mode[IP] |= 0x10;
    // Break out upon reaching an already-processed code area.
-      if ((Mode[IP]&0x0f) == Opcode) break;
+      if ((Mode[IP]&0x0f) == Opcode) End = true;
    // Abort upon finding an operator/operand collision; i.e. overlapping opcode areas.
-      if ((Mode[IP]&0x0f) == Operand) { printf("Illegal jump at addr %4.4XH\n", IP); return; }
-   // Mark the opcode area as an operator followed by operands.
-      Mode[IP] = Opcode;
-      int N = OpLen(IP);
-      for (int16_t n = 1; n < N; n++) Mode[IP + n] = Operand;
-   // Mark address references to the opcode area.
-      if (Label) Mode[IP] |= 0x10, Label = false;
-      uint32_t IP0 = IP, NextIP = IP0 + N; // Save the next opcode.
-      uint8_t Op;
-   MainOp:
-      switch (Op = GetB(IP)) { // Fetch the primary opcode.
-      // jp Cc,Aw; [Cc: nz; z; nc; c; po; pe; p; m]
-         case 0302: case 0312: case 0322: case 0332: case 0342: case 0352: case 0362: case 0372: OpScan(GetW(IP)); break;
-      // jr Cc,Js; [Cc: nz; z; nc; c]
-         case 0040: case 0050: case 0060: case 0070: OpScan(GetJs(IP)); break;
-      // call Cc,Aw; [Cc: nz; z; nc; c; po; pe; p; m]
-         case 0304: case 0314: case 0324: case 0334: case 0344: case 0354: case 0364: case 0374: OpScan(GetW(IP)); break;
-      // rst 10q*n; [n: 0; 1; 2; 3; 4; 5; 6; 7]
-         case 0307: case 0317: case 0327: case 0337: case 0347: case 0357: case 0367: case 0377: OpScan(Op&070); break;
-      // djnz Js
-         case 0020: OpScan(GetJs(IP)); break;
-      // jp Aw
-         case 0303: NextIP = GetW(IP), Label = true; break;
-      // jr Js
-         case 0030: NextIP = GetJs(IP), Label = true; break;
-      // call Aw
-         case 0315: OpScan(GetW(IP)); break;
-      // ret
-         case 0311: return;
-#if DETECT_JUMPTABLES
-      // jp (HL), jp (IX) if prefixed by 0335 or jp (IY) if prefixed by 0375.
-         case 0351: puts("JP (...) found"), exit(-1);
-#else
-         case 0351: return;
-#endif
-         case 0335: case 0375: goto MainOp;
-      // retn; reti
-         case 0355: switch (Op = GetB(IP)) {
-            case 0105: case 0115: return;
+      else if ((Mode[IP]&0x0f) == Operand || (Mode[IP]&0x0f) == Word) {
+         if (!ScanQuiet) printf("Illegal jump at addr %4.4XH (%s from %4.4XH)\n", IP, WhyName[Why], From);
+         End = true, ScanClash++;
+      }
+   // Abort upon finding a byte that is not an opcode of the processor (for the 8080 and 8085).
+      else if (Decode(IP), DcInfo(IP).Form == FmBad) {
+         if (!ScanQuiet) printf("Illegal opcode at addr %4.4XH (%s from %4.4XH)\n", IP, WhyName[Why], From);
+         End = true, ScanClash++;
+      }
+      if (!End) {
+      // Mark the opcode area as an operator followed by operands.
+      // A stray: falling or branching out of the image, rather than calling or jumping out.
+         if ((Mode[IP]&0x0f) == Empty && (Why == ByFlow || Why == ByBranch) && From >= LoRAM && From <= HiRAM) ScanClash++;
+         Mode[IP] = Opcode;
+         int N = Decode(IP);
+         for (int16_t n = 1; n < N; n++) {
+            uint8_t &M = Mode[uint16_t(IP + n)];
+            if ((M&0x0f) != Data && (M&0x0f) != Empty) ScanClash++;
+            M = Operand;
          }
-         break;
+      // Mark address references to the opcode area.
+         if (Label) Mode[IP] |= 0x10, Label = false;
+         uint16_t IP0 = IP, NextIP = IP0 + N; // Save the next opcode.
+         Why = ByFlow;
+         Track(Regs, IP0);
+      // A branch: scan the target first, then the next opcode, with the register state NextRegs.
+#define Branch(Target, By, NextRegs) (ScanList[ScanN].IP = NextIP, ScanList[ScanN].From = IP0, ScanList[ScanN].Why = ByFlow, ScanList[ScanN++].Regs = (NextRegs), NextIP = (Target), Why = (By), Label = true)
+         switch (DcFlags[IP0]&DcFlow) {
+         // jp Cc,Aw; jr Cc,Js; djnz Js
+            case FlBranch: {
+               RegState NextRegs = Regs; int Cc = Cond(IP0);
+            // A range check on A: jp NC or jr NC away from the next opcode, or jp C or jr C to the target.
+               if (Regs.Cmp != 0 && Cc == 2) Bound(NextRegs, Regs.Cmp);
+               else if (Regs.Cmp != 0 && Cc == 3) Bound(Regs, Regs.Cmp);
+               Branch(DcImm[IP0], ByBranch, NextRegs);
+            }
+            break;
+         // call [Cc,]Aw
+            case FlCall: Branch(DcImm[IP0], ByCall, RegState()), Regs = RegState(); break;
+         // rst 10q*n; [n: 0; 1; 2; 3; 4; 5; 6; 7]
+            case FlRst: Branch(DcOp[IP0]&070, ByRst, RegState()), Regs = RegState(); break;
+         // jp Aw; jr Js
+            case FlJump: NextIP = DcImm[IP0], Why = ByJump, Label = true; break;
+         // ret Cc: ret NC is also a range check on A.
+            case FlCondRet: if (Regs.Cmp != 0 && Cond(IP0) == 2) Bound(Regs, Regs.Cmp); break;
+         // ret; reti; retn
+            case FlRet: End = true; break;
+         // jp (HL); jp (IX); jp (IY)
+            case FlJumpInd:
+               JumpTable(IP0, GetPair(Regs, DcOp[IP0] >> 8 == PgDD? RwIX: DcOp[IP0] >> 8 == PgFD? RwIY: RwHL), ScanN);
+               End = true;
+            break;
+         }
+#undef Branch
+         From = IP0, IP = NextIP;
+      }
+   // At the end of a path, resume with the latest address pushed.
+      if (End) {
+         if (ScanN == 0) return;
+         const ScanItem &Item = ScanList[--ScanN];
+         IP = Item.IP, From = Item.From, Why = (ScanWhy)Item.Why, Label = Why != ByFlow, Regs = Item.Regs;
+      }
+   }
+}
+
+// Guessing code.
+// ──────────────
+// For images, like overlays, whose entry points are not known, every address still taken as data is scored as a possible start of code.
+// The scores come from one backward pass over the image, which uses only the decoded-opcode cache and flat arrays, without any scanning:
+// ▪	the run: the number of plausible opcodes in a linear sweep from the address, worth more if it ends in a jump or return, or runs into known code,
+// ▪	the references to the address by constants (‟LD rr,nn”) in the known code,
+// ▪	a prologue (‟PUSH rr”, ‟DI”), or a boundary (the start of the image, a ‟RET” or known code) just before it,
+// ▪	and, against it, a run of text or of fill bytes.
+// The candidates are then tried out with OpScan() in the order of decreasing score, so that the conflicts are settled by confidence:
+// a candidate is only kept if its scan meets no code or table already known or kept, and neither falls nor branches out of the image.
+// The code kept may refer to more code, so this is repeated until no more candidates are kept.
+static const int GuessMin = 40;	// The least score of a candidate.
+static int16_t GuessScore[CodeMax];
+
+// An opcode unlikely to be found in code: fill bytes, and the opcodes that are undocumented or duplicates of others.
+static bool Unlikely(uint16_t IP) {
+   int Page = DcOp[IP] >> 8, Op = DcOp[IP]&0xff, X = Op >> 6, Y = (Op >> 3)&7, Z = Op&7;
+   switch (Page) {
+   // Also, a prefix that does not apply.
+      case PgBase: return Op == 0000 || Op == 0166 || Op == 0377 || Code[IP] == 0335 || Code[IP] == 0375;
+      case PgCB: return X == 0 && Y == 6;
+      case PgED:
+         if (X == 2) return Z >= 4 || Y < 4;
+         if (X != 1) return true;
+         switch (Z) {
+            case 0: case 1: return Y == 6;
+            case 4: return Op != 0104;
+            case 5: return Op != 0105 && Op != 0115;
+            case 6: return (Y&3) == 1;
+            case 7: return Y >= 6;
+            default: return false;
+         }
+   // The halves of IX and IY.
+      case PgDD: case PgFD: {
+         const char *Text = DcInfo(IP).Text;
+         return strstr(Text, "%xH") != nullptr || strstr(Text, "%xL") != nullptr || strstr(Text, "%x%y") != nullptr;
       }
-      IP = NextIP;
+   // sll, and the copies to a register.
+      default: return X == 0 && Y == 6 || X != 1 && Z != 6;
    }
 }
 
-static void _Gen(char *Buf, size_t BufN, const char *Format, ...) {
-   va_list AP; va_start(AP, Format), vsnprintf(Buf, BufN, Format, AP), va_end(AP);
+// By decreasing score, then by address.
+static int CompareScore(const void *A, const void *B) {
+   uint16_t IA = *(const uint16_t *)A, IB = *(const uint16_t *)B;
+   return GuessScore[IA] != GuessScore[IB]? GuessScore[IB] - GuessScore[IA]: IA - IB;
+}
+
+// One round of guessing; return the number of candidates kept.
+static int GuessRound(void) {
+   static uint8_t Run[CodeMax];	// The length of the run from each address, up to 0xff opcodes.
+   static bool Ends[CodeMax];	// The run ends in a jump, a return or known code.
+   static uint8_t Refs[CodeMax];	// The references by constants in the known code, up to 4.
+   static uint8_t Saved[CodeMax];
+   memset(Refs, 0, sizeof Refs);
+   for (uint32_t IP = LoRAM; IP <= HiRAM; IP++)
+      if ((Mode[IP]&0x0f) == Opcode && (DcOp[IP] < 0x100? (DcOp[IP]&0317) == 0001: (DcOp[IP]&0xff) == 0041)) {
+         uint16_t Ref = DcImm[IP];
+         if (Ref >= LoRAM && Ref <= HiRAM && Refs[Ref] < 4) Refs[Ref]++;
+      }
+// The backward pass.
+   uint32_t CandN = 0;
+   for (uint32_t IP = HiRAM + 1; IP-- > LoRAM; ) {
+      Run[IP] = 0, Ends[IP] = false, GuessScore[IP] = 0;
+      if ((Mode[IP]&0x0f) != Data) continue;
+      uint32_t Next = IP + Decode(IP);
+      if (Next - 1 > HiRAM || Unlikely(IP)) continue;
+      switch (DcFlags[IP]&DcFlow) {
+         case FlJump: case FlRet: case FlJumpInd: Run[IP] = 1, Ends[IP] = true; break;
+         default:
+            if (Next > HiRAM) Run[IP] = 1;
+            else if ((Mode[Next]&0x0f) == Opcode) Run[IP] = 1, Ends[IP] = true;
+            else if (Run[Next] > 0) Run[IP] = Run[Next] < 0xff? Run[Next] + 1: 0xff, Ends[IP] = Ends[Next];
+         break;
+      }
+      if (Run[IP] == 0) continue;
+      int Score = (Run[IP] < 16? Run[IP]: 16)*(Ends[IP]? 4: 1) + 16*Refs[IP];
+      const uint8_t *C = &Code[IP];
+      if ((C[0]&0317) == 0305 || C[0] == 0363 || (C[0] == 0335 || C[0] == 0375) && C[1] == 0345) Score += 8;
+      if (IP == LoRAM || C[-1] == 0311 || (Mode[IP - 1]&0x0f) == Opcode || (Mode[IP - 1]&0x0f) == Operand) Score += 8;
+      if (IP + 3 <= HiRAM) {
+         bool Text = true; for (int n = 0; n < 4; n++) Text = Text && C[n] >= 0x20 && C[n] < 0x7f;
+         if (Text) Score -= 32;
+         if (C[0] == C[1] && C[1] == C[2] && C[2] == C[3]) Score -= 32;
+      }
+      GuessScore[IP] = Score;
+      if (Score >= GuessMin) CandN++;
+   }
+   if (CandN == 0) return 0;
+   uint16_t *Cands = (uint16_t *)malloc(CandN*sizeof *Cands); if (Cands == nullptr) exit(1);
+   CandN = 0;
+   for (uint32_t IP = LoRAM; IP <= HiRAM; IP++) if (GuessScore[IP] >= GuessMin) Cands[CandN++] = IP;
+   qsort(Cands, CandN, sizeof *Cands, CompareScore);
+// Try each candidate out quietly; scan it again, for real, if it is kept.
+   int KeptN = 0;
+   for (uint32_t Cand = 0; Cand < CandN; Cand++) {
+      uint16_t IP = Cands[Cand];
+      if ((Mode[IP]&0x0f) != Data) continue;
+      memcpy(Saved, Mode, CodeMax);
+      ScanClash = 0, ScanQuiet = true, OpScan(IP, ByGuess), ScanQuiet = false;
+      memcpy(Mode, Saved, CodeMax);
+      if (ScanClash > 0) continue;
+      printf("Guessed code at %4.4XH (score %d)\n", IP, GuessScore[IP]);
+      OpScan(IP, ByGuess), KeptN++;
+   }
+   free(Cands);
+   return KeptN;
 }
-#define Gen(...) _Gen(Buf, BufN, __VA_ARGS__)
 
-// Disassemble.
-static void Disassemble(uint16_t IP, char *Buf, size_t BufN) {
-   uint8_t Op = GetB(IP), X = (Op >> 6)&3, Y = (Op >> 3)&7, Z = Op&7, Yq;
-   static const char *Rb[8] = { "B", "C", "D", "E", "H", "L", "(HL)", "A" };
-   static const char *Rw[4] = { "BC", "DE", "HL", "SP" };
+static void GuessCode(void) { while (GuessRound() > 0); }
+
+// Symbols.
+// ────────
+// The labels of an image built by CasZ80 may be loaded, with -y, from the symbol snapshot that it saves with its own -w.
+// Each address is then named by its symbol, rather than by ‟L” and its hex digits, in the labels and in the operands that are addresses or words.
+// The names are indexed by address in a flat table, so the lookup costs the same for any number of symbols.
+// A symbol used in the output but not at the start of a line is defined with ‟EQU” in front of the lines.
+static const char *SymName[CodeMax];	// The symbol at each address, or nullptr.
+static uint32_t SymN;			// The number of addresses named.
+
+// Disassemble into Buf; return the length of the text.
+static size_t Disassemble(uint16_t IP, char *Buf, size_t BufN) {
+   static const char *ZRb[8] = { "B", "C", "D", "E", "H", "L", "(HL)", "A" }, *IRb[8] = { "B", "C", "D", "E", "H", "L", "M", "A" };
+   static const char *ZRw[4] = { "BC", "DE", "HL", "SP" }, *IRw[4] = { "B", "D", "H", "SP" };
+   const char *const *Rb = BasePg == PgBase? ZRb: IRb, *const *Rw = BasePg == PgBase? ZRw: IRw;
    static const char *Cc[8] = { "NZ", "Z", "NC", "C", "PO", "PE", "P", "M" };
    static const char *AOp[8] = { "ADD     A,", "ADC     A,", "SUB", "SBC     A,", "AND", "XOR", "OR", "CP" };
    static const char *ShOp[8] = { "RLC", "RRC", "RL", "RR", "SLA", "SRA", "SLL", "SRL" };
-   static const char *S0Op[8] = { "RLCA", "RRCA", "RLA", "RRA", "DAA", "CPL", "SCF", "CCF" };
-   static const char *BOp[4][4] = {
-      "LDI", "LDD", "LDIR", "LDDR",
-      "CPI", "CPD", "CPIR", "CPDR",
-      "INI", "IND", "INIR", "INDR",
-      "OUTI", "OUTD", "OTIR", "OTDR",
-   };
-   const char *Rx; // Temporary index register string.
-MainOp:
-   switch (X) {
-      case 0: switch (Z) {
-         case 0: switch (Y) {
-            case 0: Gen("NOP"); break;
-            case 1: Gen("EX      AF,AF'"); break;
-            case 2: Gen("DJNZ    %c%4.4X", NumPre, GetJs(IP)); break;
-            case 3: Gen("JR      %c%4.4X", NumPre, GetJs(IP)); break;
-            default: Gen("JR      %s,%c%4.4X", Cc[Y&3], NumPre, GetJs(IP)); break;
-         }
-         break;
-         case 1: switch (Yq = Y >> 1, Y&1) {
-            case 0: Gen("LD      %s,$%4.4X", Rw[Yq], GetW(IP)); break;
-            case 1: Gen("ADD     HL,%s", Rw[Yq]); break;
+   static const char Hex[] = "0123456789ABCDEF";
+   Decode(IP);
+   uint8_t Op = DcOp[IP]&0xff, Y = (Op >> 3)&7, Z = Op&7;
+   int16_t Ds = DcDs[IP]; uint16_t Imm = DcImm[IP];
+   char *BP = Buf, *EndP = Buf + BufN - 1;
+#define Put(Ch) (BP < EndP? *BP++ = (Ch): 0)
+   for (const char *TP = DcInfo(IP).Text; *TP != '\0'; TP++) {
+      if (*TP != '%') { Put(*TP); continue; }
+      const char *S = nullptr; unsigned Pad = 0, Num = 0, Digits = 0;
+      switch (*++TP) {
+         case 'y': S = Rb[Y]; break;
+         case 'z': S = Rb[Z]; break;
+         case 'p': S = Rw[Y >> 1]; break;
+         case 'q': S = Y >> 1 != 3? Rw[Y >> 1]: BasePg == PgBase? "AF": "PSW"; break;
+         case 'c': S = Cc[Y]; break;
+         case 'k': S = Cc[Y&3]; break;
+         case 'a': S = AOp[Y], Pad = 8; break;
+         case 's': S = ShOp[Y], Pad = 8; break;
+         case 'n': Put('0' + Y); break;
+         case 'x': S = DcFlags[IP]&DcIY? "IY": "IX"; break;
+         case 'd': Put(Ds >= 0? '+': '-'), Put('$'), Num = Ds >= 0? Ds: -Ds, Digits = 2; break;
+         case 'r': Put('$'), Num = Op&070, Digits = 2; break;
+         case 'o': Put('$'), Num = Op, Digits = 2; break;
+         case 'b': Put('$'), Num = Imm, Digits = 2; break;
+         case 'w': if ((S = SymName[Imm]) == nullptr) Put('$'), Num = Imm, Digits = 4; break;
+         case 't': case 'j': if ((S = SymName[Imm]) == nullptr) Put(NumPre), Num = Imm, Digits = 4; break;
+      }
+      if (S != nullptr) for (unsigned N = 0; *S != '\0' || N < Pad; N++) Put(*S != '\0'? *S++: ' ');
+      while (Digits > 0) Digits--, Put(Hex[(Num >> 4*Digits)&0xf]);
+   }
+#undef Put
+   *BP = '\0';
+   return BP - Buf;
+}
+
+// The output.
+// ───────────
+// The lines are rendered in chunks, each starting at the start of a line, by several threads at once, each chunk into its own buffer.
+// The buffers are then joined in order and written out at once, so the output is the same as it is with one thread.
+// The opcodes are all decoded while the chunks are laid out, so the threads only read the decoded-opcode cache.
+// Each line is formatted without printf: straight into the buffer, with the hex digits from a table.
+struct OutBuf { char *Buf; size_t N, Max; };
+
+// Make room for N more bytes in B; return where they go.
+static char *Room(OutBuf &B, size_t N) {
+   if (B.N + N > B.Max) {
+      B.Max = 2*(B.N + N) > 0x10000? 2*(B.N + N): 0x10000;
+      B.Buf = (char *)realloc(B.Buf, B.Max); if (B.Buf == nullptr) exit(1);
+   }
+   return B.Buf + B.N;
+}
+
+// The two hex digits of each byte.
+struct HexTab { char D[0x100][2]; };
+
+constexpr HexTab MakeHex() {
+   HexTab T{};
+   for (int B = 0; B < 0x100; B++) T.D[B][0] = "0123456789ABCDEF"[B >> 4], T.D[B][1] = "0123456789ABCDEF"[B&0xf];
+   return T;
+}
+
+static constexpr HexTab Hex2 = MakeHex();
+
+static inline char *PutS(char *P, const char *S, size_t N) { memcpy(P, S, N); return P + N; }
+static inline char *PutB(char *P, uint8_t B) { P[0] = Hex2.D[B][0], P[1] = Hex2.D[B][1]; return P + 2; }
+static inline char *PutW(char *P, uint16_t W) { return PutB(PutB(P, W >> 8), W&0xff); }
+
+// The label of the line at IP: its symbol, if it has one, or else Pre and its hex digits, followed by the colon and padded to the opcode.
+static char *PutLabel(char *P, uint16_t IP, char Pre) {
+   const char *Name = SymName[IP];
+   if (Name == nullptr) return *P++ = Pre, P = PutW(P, IP), PutS(P, ":  ", 3);
+   size_t N = strlen(Name);
+   P = PutS(P, Name, N), *P++ = ':';
+   for (*P++ = ' '; N < 6; N++) *P++ = ' ';
+   return P;
+}
+
+// A word: its symbol, if it has one, or else Pre and its hex digits.
+static char *PutName(char *P, uint16_t W, char Pre) {
+   const char *Name = SymName[W];
+   return Name != nullptr? PutS(P, Name, strlen(Name)): (*P++ = Pre, PutW(P, W));
+}
+
+// Text, fills and repeated words.
+// ───────────────────────────────
+// With -a, the data left between the labels is classified before it is written out:
+// runs of printable ASCII (other than '"'), each possibly ended by a byte with bit 7 set, are written as ‟DEFM”,
+// runs of 0x00 or 0xff as ‟FILL” and runs of a repeated word as ‟DEFW”; the rest is written as ‟DEFB”, as before.
+// The runs are scanned a word of 8 bytes at a time, with the usual tests for a byte less than or more than a bound in each of them.
+enum { DfByte, DfText, DfFill, DfWord, DfHead = 0x80 };
+static uint8_t DataForm[CodeMax];	// The form of the run that each byte of data is in, with DfHead on the first byte of each run.
+static bool OutText;	// Option -a.
+static const uint32_t TextMin = 4, FillMin = 8, WordMin = 4;	// The shortest runs taken.
+
+static const uint64_t Ones = 0x0101010101010101ULL, Highs = 0x8080808080808080ULL;
+static inline uint64_t Load8(uint32_t IP) { uint64_t W; memcpy(&W, Code + IP, 8); return W; }
+static inline uint64_t HasLess(uint64_t W, uint8_t N) { return (W - N*Ones)&~W&Highs; }	// N ≤ 0x80.
+static inline uint64_t HasMore(uint64_t W, uint8_t N) { return ((W + (0x7f - N)*Ones) | W)&Highs; }	// N < 0x80.
+static inline bool IsText(uint8_t B) { return B >= 0x20 && B < 0x7f && B != '"'; }
+
+// The length of the run of the byte at Lo, of the printable text at Lo and of the word at Lo repeated, up to Hi.
+static uint32_t SameRun(uint32_t Lo, uint32_t Hi) {
+   uint32_t IP = Lo; uint64_t W = Code[Lo]*Ones;
+   while (IP + 8 <= Hi && Load8(IP) == W) IP += 8;
+   while (IP < Hi && Code[IP] == Code[Lo]) IP++;
+   return IP - Lo;
+}
+
+static uint32_t TextRun(uint32_t Lo, uint32_t Hi) {
+   uint32_t IP = Lo;
+   for (; IP + 8 <= Hi; IP += 8) {
+      uint64_t W = Load8(IP);
+      if (HasLess(W, 0x20) | HasMore(W, 0x7e) | HasLess(W ^ '"'*Ones, 1)) break;
+   }
+   while (IP < Hi && IsText(Code[IP])) IP++;
+   return IP - Lo;
+}
+
+static uint32_t WordRun(uint32_t Lo, uint32_t Hi) {
+   uint32_t IP = Lo + 2;
+   while (IP + 2 <= Hi && Code[IP] == Code[Lo] && Code[IP + 1] == Code[Lo + 1]) IP += 2;
+// The first 8 bytes are then 4 copies of the word, to compare the rest against.
+   if (IP - Lo >= 8) for (uint64_t W = Load8(Lo); IP + 8 <= Hi && Load8(IP) == W; ) IP += 8;
+   while (IP + 2 <= Hi && Code[IP] == Code[Lo] && Code[IP + 1] == Code[Lo + 1]) IP += 2;
+   return IP - Lo;
+}
+
+static void MarkRun(uint32_t Lo, uint32_t N, uint8_t Form) { memset(DataForm + Lo, Form, N), DataForm[Lo] |= DfHead; }
+
+// Classify the data from IP up to the end of the image, each stretch between the labels and the code on its own.
+static void FindText(uint32_t IP) {
+   memset(DataForm, DfByte, sizeof DataForm);
+   while (IP <= HiRAM) {
+      if ((Mode[IP]&0x0f) != Data) { IP++; continue; }
+      uint32_t Hi = IP + 1;
+      while (Hi <= HiRAM && (Mode[Hi]&0x0f) == Data && SymName[Hi] == nullptr) Hi++;
+      for (uint32_t N; IP < Hi; ) {
+         if ((Code[IP] == 0x00 || Code[IP] == 0xff) && (N = SameRun(IP, Hi)) >= FillMin) MarkRun(IP, N, DfFill);
+         else if ((N = TextRun(IP, Hi)) >= TextMin) {
+            if (IP + N < Hi && Code[IP + N]&0x80 && IsText(Code[IP + N]&0x7f)) N++;
+            MarkRun(IP, N, DfText);
+         } else if (IP + 2*WordMin <= Hi && (N = WordRun(IP, Hi)) >= 2*WordMin) MarkRun(IP, N, DfWord);
+         else N = 1;
+         IP += N;
+      }
+   }
+}
+
+// The start of the line after the one starting at IP.
+static uint32_t NextLine(uint32_t IP) {
+   switch (Mode[IP]&0x0f) {
+      case Data: {
+         uint32_t Lo = IP; uint8_t Form = DataForm[Lo]&~DfHead;
+         switch (Form) {
+         // The whole fill on one line, the text 64 characters or up to its end to a line and the words 8 to a line.
+            case DfFill: IP++; while (IP <= HiRAM && DataForm[IP] == Form && Code[IP] == Code[Lo] && IP - Lo < 0x8000) IP++; break;
+            case DfText: while (IP - Lo < 0x40 && IP <= HiRAM && (IP == Lo || DataForm[IP] == Form) && !(Code[IP++]&0x80)); break;
+            case DfWord: IP += 2; while (IP - Lo < 0x10 && IP <= HiRAM && DataForm[IP] == Form) IP += 2; break;
+            default:
+               while (IP - Lo < 16 && IP <= HiRAM && (Mode[IP]&0x0f) == Data && (IP == Lo || SymName[IP] == nullptr && DataForm[IP] == DfByte)) IP++;
+            break;
          }
+         return IP;
+      }
+      case Word: return IP + 2;
+      default: return IP + Decode(IP);
+   }
+}
+
+// The lines from Lo up to Hi, where Hi is the start of a line or past the end of the image.
+struct Chunk {
+   uint32_t Lo, Hi;
+   OutBuf Text;
+};
+
+static bool OutHex, OutParse;	// Options -x and -p.
+
+// The notes of the analyses, each put after the line at its address as a comment.
+static char *NoteBuf; static uint32_t NoteN, NoteMax;
+static uint32_t NoteAt[CodeMax];	// The note at each address, as its offset in NoteBuf plus 1, or 0.
+static const unsigned NoteCol = 40;	// The column of the notes.
+
+// Add to the note at IP.
+static void AddNote(uint16_t IP, const char *Format, ...) {
+   char Buf[0x100]; va_list AP; va_start(AP, Format); vsnprintf(Buf, sizeof Buf, Format, AP); va_end(AP);
+   const char *Old = NoteAt[IP] != 0? NoteBuf + NoteAt[IP] - 1: nullptr;
+   size_t N = (Old != nullptr? strlen(Old) + 2: 0) + strlen(Buf) + 1;
+   if (NoteN + N > NoteMax) {
+      NoteMax = 2*(NoteN + N) > 0x1000? 2*(NoteN + N): 0x1000;
+      NoteBuf = (char *)realloc(NoteBuf, NoteMax); if (NoteBuf == nullptr) exit(1);
+      if (NoteAt[IP] != 0) Old = NoteBuf + NoteAt[IP] - 1;
+   }
+   snprintf(NoteBuf + NoteN, N, "%s%s%s", Old != nullptr? Old: "", Old != nullptr? ", ": "", Buf);
+   NoteAt[IP] = NoteN + 1, NoteN += N;
+}
+
+static void ClearNotes(void) { memset(NoteAt, 0, sizeof NoteAt), NoteN = 0; }
+
+static void Render(Chunk &C) {
+   OutBuf &B = C.Text;
+   const size_t LineMax = 0x200; // More than the longest line.
+   for (uint32_t IP = C.Lo, Next; IP < C.Hi && IP <= HiRAM; IP = Next) {
+      Next = NextLine(IP);
+      const char *Note = NoteAt[IP] != 0? NoteBuf + NoteAt[IP] - 1: nullptr;
+      char *P = Room(B, LineMax + (Note != nullptr? strlen(Note): 0)), *Line = P;
+      switch (Mode[IP]&0x0f) {
+         case Data:
+            P = PutLabel(P, IP, 'L');
+            switch (DataForm[IP]&~DfHead) {
+               case DfFill: P = PutS(P, "FILL    $", 9), P = PutW(P, Next - IP), P = PutS(P, ",$", 2), P = PutB(P, Code[IP]); break;
+               case DfText: {
+                  uint32_t End = Code[Next - 1]&0x80? Next - 1: Next;
+                  P = PutS(P, "DEFM    \"", 9), P = PutS(P, (const char *)Code + IP, End - IP), *P++ = '"';
+                  if (End < Next) P = PutS(P, ",$", 2), P = PutB(P, Code[End]);
+               }
+               break;
+               case DfWord:
+                  P = PutS(P, "DEFW    ", 8);
+                  for (uint32_t n = IP; n < Next; n += 2) {
+                     if (n > IP) *P++ = ',';
+                     *P++ = '$', P = PutW(P, Code[n] | Code[n + 1] << 8);
+                  }
+               break;
+               default:
+                  P = PutS(P, "DEFB    ", 8);
+                  for (uint32_t n = IP; n < Next; n++) {
+                     if (n > IP) *P++ = ',';
+                     *P++ = '$', P = PutB(P, Code[n]);
+                  }
+               break;
+            }
          break;
-         case 2: switch (Y) {
-            case 0: Gen("LD      (BC),A"); break;
-            case 1: Gen("LD      A,(BC)"); break;
-            case 2: Gen("LD      (DE),A"); break;
-            case 3: Gen("LD      A,(DE)"); break;
-            case 4: Gen("LD      ($%4.4X),HL", GetW(IP)); break;
-            case 5: Gen("LD      HL,($%4.4X)", GetW(IP)); break;
-            case 6: Gen("LD      ($%4.4X),A", GetW(IP)); break;
-            case 7: Gen("LD      A,($%4.4X)", GetW(IP)); break;
-         }
+         case Word:
+            P = PutLabel(P, IP, 'L'), P = PutS(P, "DEFW    ", 8);
+            P = PutName(P, Code[IP] | Code[uint16_t(IP + 1)] << 8, NumPre);
          break;
-         case 3: switch (Yq = Y >> 1, Y&1) {
-            case 0: Gen("INC     %s", Rw[Yq]); break;
-            case 1: Gen("DEC     %s", Rw[Yq]); break;
+         default: {
+            uint32_t N = Next - IP;
+            if (!OutHex) {
+               if (Mode[IP]&0x10 || SymName[IP] != nullptr) P = PutLabel(P, IP, OutParse? 'L': '$');
+               else P = PutS(P, "        ", 8);
+            } else {
+               if (SymName[IP] != nullptr) P = PutS(P, SymName[IP], strlen(SymName[IP])), P = PutS(P, ":\n", 2), Line = P;
+               *P++ = OutParse? 'L': '$', P = PutW(P, IP), P = PutS(P, "   ", 3);
+               for (uint32_t n = 0; n < N; n++) P = PutB(P, Code[uint16_t(IP + n)]), *P++ = ' ';
+               for (uint32_t n = 4; n > N; n--) P = PutS(P, "   ", 3);
+               P = PutS(P, "    ", 4);
+            }
+            P += Disassemble(IP, P, 0x100);
          }
          break;
-         case 4: Gen("INC     %s", Rb[Y]); break;
-         case 5: Gen("DEC     %s", Rb[Y]); break;
-         case 6: Gen("LD      %s,$%2.2X", Rb[Y], GetB(IP)); break;
-         case 7: Gen("%s", S0Op[Y]); break;
       }
-      break;
-   // ld Rd,Rs or halt.
-      case 1: switch (Op&077) {
-      // Order 66.
-         case 066: Gen("HALT"); break;
-         default: Gen("LD      %s,%s", Rb[Y], Rb[Z]); break;
+      if (Note != nullptr) {
+         do *P++ = ' '; while (P - Line < NoteCol);
+         P = PutS(P, "; ", 2), P = PutS(P, Note, strlen(Note));
       }
+      *P++ = '\n', B.N = P - B.Buf;
+   }
+}
+
+static uint8_t SymUse[CodeMax];	// Whether the symbol at each address is used in the output (SymRef) or labels a line in it (SymDef).
+static const uint8_t SymRef = 1, SymDef = 2;
+
+// Note the symbols used by the line at IP and the one labelling it.
+static void NoteSyms(uint32_t IP) {
+   SymUse[IP] |= SymDef;
+   switch (Mode[IP]&0x0f) {
+      case Data: break;
+      case Word: SymUse[Code[IP] | Code[uint16_t(IP + 1)] << 8] |= SymRef; break;
+      default:
+         Decode(IP);
+         if (DcInfo(IP).Form == FmW || DcInfo(IP).Form == FmJ) SymUse[DcImm[IP]] |= SymRef;
       break;
-      case 2: Gen("%-8s%s", AOp[Y], Rb[Z]); break;
-      case 3: switch (Z) {
-         case 0: Gen("RET     %s", Cc[Y]); break;
-         case 1: switch (Yq = Y >> 1, Y&1) {
-            case 0: Gen("POP     %s", Yq == 3? "AF": Rw[Yq]); break;
-            case 1: switch (Yq) {
-               case 0: Gen("RET"); break;
-               case 1: Gen("EXX"); break;
-               case 2: Gen("JP      (HL)"); break;
-               case 3: Gen("LD      SP,HL"); break;
-            }
+   }
+}
+
+// Define the symbols used, but not labelling any line, in B.
+static void PutEquates(OutBuf &B) {
+   for (uint32_t IP = 0; IP < CodeMax; IP++) if (SymName[IP] != nullptr && SymUse[IP] == SymRef) {
+      char *P = Room(B, 0x100);
+      P = PutLabel(P, IP, 'L'), P = PutS(P, "EQU     $", 9), P = PutW(P, IP), *P++ = '\n';
+      B.N = P - B.Buf;
+   }
+}
+
+// Render the chunks with ThreadN threads, each thread taking the next chunk left, with Draw; then join them and write them out.
+static void PutChunks(FILE *ExF, Chunk *Chunks, unsigned ChunkN, unsigned ThreadN, void (*Draw)(Chunk &C)) {
+   std::atomic<unsigned> NextChunk(0);
+   auto Work = [&]() { for (unsigned K; (K = NextChunk++) < ChunkN; ) Draw(Chunks[K]); };
+   std::vector<std::thread> Threads;
+   for (unsigned T = 1; T < ThreadN && T < ChunkN; T++) Threads.emplace_back(Work);
+   Work();
+   for (std::thread &Th: Threads) Th.join();
+   size_t N = 0;
+   for (unsigned K = 0; K < ChunkN; K++) N += Chunks[K].Text.N;
+   char *Buf = (char *)malloc(N + 1); if (Buf == nullptr) exit(1);
+   for (unsigned K = 0, At = 0; K < ChunkN; At += Chunks[K].Text.N, free(Chunks[K].Text.Buf), K++) memcpy(Buf + At, Chunks[K].Text.Buf, Chunks[K].Text.N);
+   fwrite(Buf, 1, N, ExF);
+   free(Buf), free(Chunks);
+}
+
+// Write out the lines from IP to the end of the image, with ThreadN threads.
+static void WriteLines(FILE *ExF, uint32_t IP, unsigned ThreadN) {
+// Lay the chunks out: a few for each thread, so that they even out.
+   uint32_t ChunkSize = (HiRAM + 1 - IP)/(4*ThreadN) + 1;
+   Chunk *Chunks = nullptr; unsigned ChunkN = 0, ChunkMax = 0;
+   if (SymN > 0) memset(SymUse, 0, sizeof SymUse);
+   if (OutText) FindText(IP);
+   for (uint32_t Lo = IP; IP <= HiRAM; ) {
+      if (SymN > 0) NoteSyms(IP);
+      IP = NextLine(IP);
+      if (IP - Lo < ChunkSize && IP <= HiRAM) continue;
+      if (ChunkN >= ChunkMax) {
+         ChunkMax = ChunkMax == 0? 0x40: 2*ChunkMax;
+         Chunks = (Chunk *)realloc(Chunks, ChunkMax*sizeof *Chunks); if (Chunks == nullptr) exit(1);
+      }
+      Chunk &C = Chunks[ChunkN++]; C.Lo = Lo, C.Hi = IP, C.Text = OutBuf{ nullptr, 0, 0 };
+      Lo = IP;
+   }
+// The equates, then the chunks.
+   if (SymN > 0) {
+      OutBuf Equ{ nullptr, 0, 0 }; PutEquates(Equ);
+      if (Equ.N > 0) fwrite(Equ.Buf, 1, Equ.N, ExF);
+      free(Equ.Buf);
+   }
+   PutChunks(ExF, Chunks, ChunkN, ThreadN, Render);
+}
+
+// The control flow graph.
+// ───────────────────────
+// With -c, the code found by parsing is cut into basic blocks, each ending at an opcode that is not simply followed by the next,
+// or before the next label, and the edges between them are classified by the opcode that ends the block.
+// The blocks are then grouped into routines: each call or restart target, or block with no edges into it, starts one,
+// which takes all of the blocks reached from it by the edges within a routine (EdFall, EdCond and EdJump) not already taken.
+// The call graph links the routines by the calls and restarts between them.
+// All of this is done in a few passes over the image and the edges, in time linear in their number (but for sorting the calls).
+//
+// The graph is written as DOT, or, for a file name ending in ‟.json”, as one line of JSON:
+//	{"blocks":[[Lo,Hi,Routine],⋯],"edges":[[From,To,"Kind"],⋯],"calls":[[Caller,Callee,Count],⋯]}
+// where each block is named by its first address, Hi is the address of its last opcode and a return edge has To = null.
+enum EdgeKind { EdFall, EdCond, EdJump, EdCall, EdRst, EdRet };
+static const char *EdgeName[] = { "fall", "cond", "jump", "call", "rst", "ret" };
+
+struct Block { uint16_t Lo, Last; uint32_t End, Owner; };
+struct Edge { uint32_t From, To; uint8_t Kind; };	// To = NoBlock for a return.
+static const uint32_t NoBlock = ~0U;
+
+static Block *Blocks; static uint32_t BlockN;
+static Edge *Edges; static uint32_t EdgeN, EdgeMax;
+static uint32_t BlockOf[CodeMax];	// The block of each opcode, plus 1, or 0.
+static uint32_t *OutFirst, *OutEdge;	// The edges out of the block B are Edges[OutEdge[OutFirst[B]]] to Edges[OutEdge[OutFirst[B + 1] - 1]].
+
+// An edge from the block B to Addr, if Addr starts a block.
+static void AddEdge(uint32_t B, uint32_t Addr, int Kind) {
+   uint32_t To = NoBlock;
+   if (Kind != EdRet) {
+      uint32_t T = BlockOf[uint16_t(Addr)];
+      if (T == 0 || Blocks[T - 1].Lo != uint16_t(Addr)) return;
+      To = T - 1;
+   }
+   if (EdgeN >= EdgeMax) {
+      EdgeMax = EdgeMax == 0? 0x400: 2*EdgeMax;
+      Edges = (Edge *)realloc(Edges, EdgeMax*sizeof *Edges); if (Edges == nullptr) exit(1);
+   }
+   Edges[EdgeN].From = B, Edges[EdgeN].To = To, Edges[EdgeN++].Kind = Kind;
+}
+
+static bool InRoutine(int Kind) { return Kind == EdFall || Kind == EdCond || Kind == EdJump; }
+
+static void BuildGraph(void) {
+// The blocks.
+   memset(BlockOf, 0, sizeof BlockOf);
+   if (Blocks == nullptr && (Blocks = (Block *)malloc(CodeMax*sizeof *Blocks)) == nullptr) exit(1);
+   BlockN = 0, EdgeN = 0;
+   bool Ends = true;
+   for (uint32_t IP = LoRAM, Next = LoRAM; IP <= HiRAM; ) {
+      if ((Mode[IP]&0x0f) != Opcode) { IP++; continue; }
+      if (Ends || Mode[IP]&0x10 || IP != Next) Blocks[BlockN].Lo = IP, Blocks[BlockN].Owner = NoBlock, BlockN++;
+      Block &B = Blocks[BlockN - 1];
+      BlockOf[IP] = BlockN, B.Last = IP, B.End = Next = IP + Decode(IP);
+      Ends = (DcFlags[IP]&DcFlow) != FlNone, IP = Next;
+   }
+// The edges, by the opcode that ends each block.
+   for (uint32_t B = 0; B < BlockN; B++) {
+      uint16_t Last = Blocks[B].Last; uint32_t End = Blocks[B].End;
+      switch (DcFlags[Last]&DcFlow) {
+         case FlNone: AddEdge(B, End, EdFall); break;
+         case FlJump: AddEdge(B, DcImm[Last], EdJump); break;
+         case FlBranch: AddEdge(B, DcImm[Last], EdCond), AddEdge(B, End, EdFall); break;
+         case FlCall: AddEdge(B, DcImm[Last], EdCall), AddEdge(B, End, EdFall); break;
+         case FlRst: AddEdge(B, DcOp[Last]&070, EdRst), AddEdge(B, End, EdFall); break;
+         case FlCondRet: AddEdge(B, 0, EdRet), AddEdge(B, End, EdFall); break;
+         case FlRet: AddEdge(B, 0, EdRet); break;
+         case FlJumpInd: break;
+      }
+   }
+   for (uint32_t T = 0; T < TabEdgeN; T++) if (BlockOf[TabEdges[T].From] != 0) AddEdge(BlockOf[TabEdges[T].From] - 1, TabEdges[T].To, EdJump);
+// The edges out of each block, by counting sort.
+   free(OutFirst), free(OutEdge);
+   OutFirst = (uint32_t *)calloc(BlockN + 1, sizeof *OutFirst), OutEdge = (uint32_t *)malloc((EdgeN + 1)*sizeof *OutEdge);
+   bool *Entry = (bool *)calloc(BlockN + 1, sizeof *Entry), *Into = (bool *)calloc(BlockN + 1, sizeof *Into);
+   uint32_t *Stack = (uint32_t *)malloc((BlockN + 1)*sizeof *Stack);
+   if (OutFirst == nullptr || OutEdge == nullptr || Entry == nullptr || Into == nullptr || Stack == nullptr) exit(1);
+   for (uint32_t E = 0; E < EdgeN; E++) {
+      OutFirst[Edges[E].From + 1]++;
+      if (Edges[E].To == NoBlock) continue;
+      if (Edges[E].Kind == EdCall || Edges[E].Kind == EdRst) Entry[Edges[E].To] = true; else Into[Edges[E].To] = true;
+   }
+   for (uint32_t B = 0; B < BlockN; B++) OutFirst[B + 1] += OutFirst[B];
+   for (uint32_t E = 0; E < EdgeN; E++) OutEdge[OutFirst[Edges[E].From]++] = E;
+   for (uint32_t B = BlockN; B > 0; B--) OutFirst[B] = OutFirst[B - 1];
+   OutFirst[0] = 0;
+// The routines: the entries first, then any block still left over.
+   for (int Pass = 0; Pass < 2; Pass++) for (uint32_t R = 0; R < BlockN; R++) {
+      if (Blocks[R].Owner != NoBlock || Pass == 0 && !Entry[R] && Into[R]) continue;
+      uint32_t StackN = 0; Stack[StackN++] = R, Blocks[R].Owner = R;
+      while (StackN > 0) {
+         uint32_t B = Stack[--StackN];
+         for (uint32_t O = OutFirst[B]; O < OutFirst[B + 1]; O++) {
+            const Edge &E = Edges[OutEdge[O]];
+            if (InRoutine(E.Kind) && E.To != NoBlock && Blocks[E.To].Owner == NoBlock && !Entry[E.To]) Blocks[E.To].Owner = R, Stack[StackN++] = E.To;
          }
-         break;
-         case 2: Gen("JP      %s,%c%4.4X", Cc[Y], NumPre, GetW(IP)); break;
-         case 3: switch (Y) {
-            case 0: Gen("JP      %c%4.4X", NumPre, GetW(IP)); break;
-         // 0313
-            case 1:
-               Op = GetB(IP), X = (Op >> 6)&3, Y = (Op >> 3)&7, Z = Op&7; // Fetch the secondary opcode.
-               switch (X) {
-                  case 0: Gen("%-8s%s", ShOp[Y], Rb[Z]); break;
-                  case 1: Gen("BIT     %d,%s", Y, Rb[Z]); break;
-                  case 2: Gen("RES     %d,%s", Y, Rb[Z]); break;
-                  case 3: Gen("SET     %d,%s", Y, Rb[Z]); break;
-               }
-            break;
-            case 2: Gen("OUT     ($%2.2X),A", GetB(IP)); break;
-            case 3: Gen("IN      A,($%2.2X)", GetB(IP)); break;
-            case 4: Gen("EX      (SP),HL"); break;
-            case 5: Gen("EX      DE,HL"); break;
-            case 6: Gen("DI"); break;
-            case 7: Gen("EI"); break;
+      }
+   }
+   free(Entry), free(Into), free(Stack);
+}
+
+// The caller and the callee of a call, by address.
+struct Call { uint32_t From, To; };
+
+static int CompareCall(const void *A, const void *B) {
+   const Call *CA = (const Call *)A, *CB = (const Call *)B;
+   return CA->From != CB->From? (CA->From < CB->From? -1: +1): CA->To != CB->To? (CA->To < CB->To? -1: +1): 0;
+}
+
+// The name of the block starting at Addr.
+static const char *BlockName(uint16_t Addr) {
+   static char Buf[8];
+   if (SymName[Addr] != nullptr) return SymName[Addr];
+   snprintf(Buf, sizeof Buf, "L%04X", Addr);
+   return Buf;
+}
+
+// Write the graph of the current view to ExF, as JSON or DOT.
+static void WriteGraph(FILE *ExF, bool Json) {
+   Call *Calls = (Call *)malloc((EdgeN + 1)*sizeof *Calls); if (Calls == nullptr) exit(1);
+   uint32_t CallN = 0;
+   for (uint32_t E = 0; E < EdgeN; E++) if ((Edges[E].Kind == EdCall || Edges[E].Kind == EdRst) && Edges[E].To != NoBlock)
+      Calls[CallN].From = Blocks[Blocks[Edges[E].From].Owner].Lo, Calls[CallN++].To = Blocks[Edges[E].To].Lo;
+   qsort(Calls, CallN, sizeof *Calls, CompareCall);
+   if (Json) {
+      fprintf(ExF, "{\"blocks\":[");
+      for (uint32_t B = 0; B < BlockN; B++) fprintf(ExF, "%s[%u,%u,%u]", B > 0? ",": "", Blocks[B].Lo, Blocks[B].Last, Blocks[Blocks[B].Owner].Lo);
+      fprintf(ExF, "],\"edges\":[");
+      for (uint32_t E = 0; E < EdgeN; E++) {
+         const Edge &Ed = Edges[E];
+         if (Ed.To == NoBlock) fprintf(ExF, "%s[%u,null,\"%s\"]", E > 0? ",": "", Blocks[Ed.From].Lo, EdgeName[Ed.Kind]);
+         else fprintf(ExF, "%s[%u,%u,\"%s\"]", E > 0? ",": "", Blocks[Ed.From].Lo, Blocks[Ed.To].Lo, EdgeName[Ed.Kind]);
+      }
+      fprintf(ExF, "],\"calls\":[");
+      for (uint32_t C = 0, N; C < CallN; C += N) {
+         for (N = 1; C + N < CallN && CompareCall(&Calls[C], &Calls[C + N]) == 0; N++);
+         fprintf(ExF, "%s[%u,%u,%u]", C > 0? ",": "", Calls[C].From, Calls[C].To, N);
+      }
+      fprintf(ExF, "]}\n");
+   } else {
+   // The blocks, clustered by routine, in the order of their routines (by counting sort) then of their addresses; the routines' exits are points.
+      uint32_t *Order = (uint32_t *)malloc((BlockN + 1)*sizeof *Order), *At = (uint32_t *)calloc(BlockN + 1, sizeof *At);
+      if (Order == nullptr || At == nullptr) exit(1);
+      for (uint32_t B = 0; B < BlockN; B++) At[Blocks[B].Owner + 1]++;
+      for (uint32_t B = 0; B < BlockN; B++) At[B + 1] += At[B];
+      for (uint32_t B = 0; B < BlockN; B++) Order[At[Blocks[B].Owner]++] = B;
+      fprintf(ExF, "digraph cfg {\n\tnode [shape=box, fontname=\"monospace\"];\n");
+      for (uint32_t O = 0; O < BlockN; O++) {
+         uint32_t B = Order[O], R = Blocks[B].Owner;
+         if (O == 0 || Blocks[Order[O - 1]].Owner != R) {
+            if (O > 0) fprintf(ExF, "\t}\n");
+            fprintf(ExF, "\tsubgraph \"cluster_%s\" {\n\t\tlabel=\"%s\";\n", BlockName(Blocks[R].Lo), BlockName(Blocks[R].Lo));
+            fprintf(ExF, "\t\t\"%s ret\" [shape=point];\n", BlockName(Blocks[R].Lo));
          }
+         fprintf(ExF, "\t\t\"%s\" [label=\"%s\\n%04X-%04X\"];\n", BlockName(Blocks[B].Lo), BlockName(Blocks[B].Lo), Blocks[B].Lo, Blocks[B].Last);
+      }
+      if (BlockN > 0) fprintf(ExF, "\t}\n");
+      free(Order), free(At);
+      for (uint32_t E = 0; E < EdgeN; E++) {
+         const Edge &Ed = Edges[E];
+         static const char *Style[] = { "", " style=dashed", "", " style=bold color=blue", " style=bold color=darkgreen", " style=dotted" };
+         fprintf(ExF, "\t\"%s\"", BlockName(Blocks[Ed.From].Lo));
+         fprintf(ExF, " -> \"%s%s\" [label=\"%s\"%s];\n", BlockName(Ed.To == NoBlock? Blocks[Blocks[Ed.From].Owner].Lo: Blocks[Ed.To].Lo), Ed.To == NoBlock? " ret": "", EdgeName[Ed.Kind], Style[Ed.Kind]);
+      }
+      fprintf(ExF, "}\n");
+   // The call graph.
+      fprintf(ExF, "digraph calls {\n\tnode [shape=box, fontname=\"monospace\"];\n");
+      for (uint32_t B = 0; B < BlockN; B++) if (Blocks[B].Owner == B) fprintf(ExF, "\t\"%s\";\n", BlockName(Blocks[B].Lo));
+      for (uint32_t C = 0, N; C < CallN; C += N) {
+         for (N = 1; C + N < CallN && CompareCall(&Calls[C], &Calls[C + N]) == 0; N++);
+         fprintf(ExF, "\t\"%s\"", BlockName(Calls[C].From));
+         fprintf(ExF, " -> \"%s\" [label=\"%u\"];\n", BlockName(Calls[C].To), N);
+      }
+      fprintf(ExF, "}\n");
+   }
+   free(Calls);
+}
+
+// Timing.
+// ───────
+// With -t, the worst case of each routine of the control flow graph is bounded in T-states.
+// A block costs the T-states of its opcodes, the larger of the two for a conditional one, plus the worst case of each routine that it calls,
+// or that it enters by a jump out of its own routine.
+// A repeated block opcode (‟LDIR” and the like) is counted BC times, or B times, with BC or B set before it in the same block, as by ‟LD BC,nn”.
+// The worst case of a routine is the longest path through its blocks, where each loop, a strongly connected set of blocks, counts as one block:
+// the longest path through its body, from its head, times the number of passes.
+// A loop is bounded, if it is entered only at its head and is repeated only by ‟DJNZ” back to its head:
+// it is passed through at most B times, for the value of B set, as by ‟LD B,n”, at the end of each block that enters it, or else 256 times.
+// This presumes that the body keeps B, as it does with an inner loop between ‟PUSH BC” and ‟POP BC”.
+// The loops nested in the body are bounded in the same way, from the inside out.
+// Any other loop, a ‟HALT”, a repeated block opcode with an unknown count, and recursion leave a routine unbounded.
+//
+// With -i, the regions with the interrupts disabled are bounded in the same way: from each ‟DI” to the paths' ends at ‟EI”, ‟RETI” or ‟RETN”.
+// A call within a region counts the longest path of the callee up to its own ‟EI” or return, and ends the region, if the callee always enables them.
+// A region that reaches a return of its own routine is noted as open, since it goes on in the callers.
+//
+// With -d, the stack depth of each routine is bounded: the most bytes pushed, from its entry, along any path through it and the routines that it calls.
+// Each entry point, a routine not called by any other, or a restart or NMI vector, is listed with the depth and the chain of the calls on its deepest path.
+static const uint64_t NoTime = ~0ULL;	// Unbounded; it is also the largest value, so the larger of two times is the larger number.
+
+static uint64_t AddTime(uint64_t A, uint64_t B) { return A == NoTime || B == NoTime? NoTime: A + B; }
+
+// By block.
+static uint64_t *BlockTime;	// The T-states of its own opcodes.
+static uint64_t *BlockCost;	// The T-states with those of the routines that it calls or enters, or NoTime.
+static int16_t *BlockB;		// The value of B at its end, or -1, if it is not known.
+static uint32_t *Loose;		// The address of its own opcode that leaves it unbounded, or NoBlock.
+static uint32_t *BlockWhy;	// The address that leaves its cost unbounded, or NoBlock.
+static uint8_t *Closed;		// For -i: the paths end at the block; none of the edges out of it are followed.
+static uint32_t *EnAt;		// For -i: the address of its first opcode that enables the interrupts, or NoBlock.
+static uint64_t *RoutineTime;	// The worst case of the routine that it starts.
+static uint32_t *RoutineWhy;	// The address that leaves that routine unbounded, or NoBlock.
+static uint8_t *RoutineState;	// That routine is not yet bounded (0), is being bounded (1) or has been bounded (2).
+static uint8_t *RoutineKeeps;	// For -i: that routine may return with the interrupts disabled.
+static uint32_t *Mark, *Seen, *Visit, *Low, *CompOf, *Work;	// The scratch space of the searches.
+static uint32_t Stamp;
+static bool LoopNotes;	// Note the loops: only while bounding the routines, so they are noted once.
+
+// The blocks of each routine R, RoutineBlock[RoutineFirst[R]] to RoutineBlock[RoutineFirst[R + 1] - 1], and the routines, Routines[0] to Routines[RoutineN - 1].
+static uint32_t *RoutineBlock, *RoutineFirst, *Routines, RoutineN;
+
+// Whether the opcode at IP enables the interrupts: ei, reti or retn.
+static inline bool Enables(uint16_t IP) { return DcOp[IP] == 0373 || DcOp[IP] >> 8 == PgED && (DcOp[IP]&0307) == 0105; }
+
+// The T-states of the opcodes of the block Bl from Lo to Hi, tracking what is known of B and C from its start;
+// Why is set to the first opcode of the span that leaves it unbounded, or NoBlock.
+// For the whole block (Full), the opcodes that leave it unbounded are noted and the value of B at its end is set.
+static uint64_t TimeSpan(uint32_t Bl, uint32_t Lo, uint32_t Hi, uint32_t &Why, bool Full) {
+   int RB = -1, RC = -1; uint64_t T = 0; Why = NoBlock;
+   for (uint32_t IP = Blocks[Bl].Lo; IP <= Hi; IP += DcLen[IP]) {
+      unsigned Page = DcOp[IP] >> 8, Op = DcOp[IP]&0xff; bool In = IP >= Lo;
+      const OpTime &OT = DcTimes(IP);
+      if (!In) ;
+      else if (Page == PgED && OT.T != OT.TNot) { // A repeated block opcode: by BC for ldir, cpir, lddr and cpdr, or by B for the others.
+         int N = (Op&3) < 2? (RB < 0 || RC < 0? -1: RB << 8 | RC): RB;
+         if (N < 0) { if (Why == NoBlock) Why = IP; if (Full) AddNote(IP, "count unknown: unbounded"); N = 1; }
+         else if (N == 0) N = (Op&3) < 2? 0x10000: 0x100;
+         T += uint64_t(DcTime(IP, true))*(N - 1) + DcTime(IP, false);
+      } else T += DcTime(IP, true) > DcTime(IP, false)? DcTime(IP, true): DcTime(IP, false);
+      if (Page == PgBase) switch (Op) {
+         case 0001: RB = DcImm[IP] >> 8, RC = DcImm[IP]&0xff; break;	// ld BC,nn
+         case 0006: RB = DcImm[IP]; break;				// ld B,n
+         case 0016: RC = DcImm[IP]; break;				// ld C,n
+         case 0003: case 0013:						// inc BC, dec BC
+            if (RB >= 0 && RC >= 0) { uint16_t BC = (RB << 8 | RC) + (Op == 0003? +1: -1); RB = BC >> 8, RC = BC&0xff; }
          break;
-         case 4: Gen("CALL    %s,%c%4.4X", Cc[Y], NumPre, GetW(IP)); break;
-         case 5: switch (Yq = Y >> 1, Y&1) {
-            case 0: Gen("PUSH    %s", Yq == 3? "AF": Rw[Yq]); break;
-            case 1: switch (Yq) {
-               case 0: Gen("CALL    %c%4.4X", NumPre, GetW(IP)); break;
-            // 0355
-               case 2:
-                  Op = GetB(IP), X = (Op >> 6)&3, Y = (Op >> 3)&7, Z = Op&7; // Fetch the secondary opcode.
-                  switch (X) {
-                  // Undocumented: "nop".
-                     case 0: case 3: UnDocNop: Gen("NOP"); break;
-                     case 1: switch (Z) {
-                        case 0: switch (Y) {
-                        // Undocumented: "in (C)" set flags but do not modify a reg.
-                           case 6: Gen("IN      (C)"); break;
-                           default: Gen("IN      %s,(C)", Rb[Y]); break;
-                        }
-                        break;
-                        case 1: switch (Y) {
-                        // Undocumented: "out (C), 0" output 0.
-                           case 6: Gen("OUT     (C),0"); break;
-                           default: Gen("OUT     (C),%s", Rb[Y]); break;
-                        }
-                        break;
-                        case 2: switch (Yq = Y >> 1, Y&1) {
-                           case 0: Gen("SBC     HL,%s", Rw[Yq]); break;
-                           case 1: Gen("ADC     HL,%s", Rw[Yq]); break;
-                        }
-                        break;
-                        case 3: switch (Yq = Y >> 1, Y&1) {
-                           case 0: Gen("LD      ($%4.4X),%s", GetW(IP), Rw[Yq]); break;
-                           case 1: Gen("LD      %s,($%4.4X)", Rw[Yq], GetW(IP)); break;
-                        }
-                        break;
-                        case 4: switch (Y) {
-                        // Undocumented: the default case is also "neg".
-                           default:
-                           case 0: Gen("NEG"); break;
-                        }
-                        break;
-                        case 5: switch (Y) {
-                        // Undocumented: the default case is also "retn".
-                           default:
-                           case 0: Gen("RETN"); break;
-                           case 1: Gen("RETI"); break;
-                        }
-                        break;
-                        case 6: switch (Y&3) {
-                           case 0: Gen("IM      0"); break;
-                           case 1: Gen("IM      0/1"); break;
-                           case 2: Gen("IM      1"); break;
-                           case 3: Gen("IM      2"); break;
-                        }
-                        break;
-                        case 7: switch (Y) {
-                           case 0: Gen("LD      I,A"); break;
-                           case 1: Gen("LD      R,A"); break;
-                           case 2: Gen("LD      A,I"); break;
-                           case 3: Gen("LD      A,R"); break;
-                           case 4: Gen("RRD"); break;
-                           case 5: Gen("RLD"); break;
-                           default: goto UnDocNop;
-                        }
-                        break;
-                     }
-                     break;
-                     case 2: switch (Z) {
-                        case 0: case 1: case 2: case 3: switch (Y) {
-                           default: goto UnDocNop;
-                           case 4: case 5: case 6: case 7: Gen("%s", BOp[Z][Y&3]); break;
-                        }
-                        break;
-                        default: goto UnDocNop;
-                     }
-                     break;
-                  }
-               break;
-            // 335: IX, 375: IY.
-               case 1: case 3: {
-                  int16_t Ds; // Used for signed address indexes.
-                  Rx = (Yq&2)? "IY": "IX";
-                  Op = GetB(IP), Y = (Op >> 3)&7, Z = Op&7; // Fetch the secondary opcode.
-                  switch (Op) {
-                     default: goto MainOp;
-                     case 0011: Gen("ADD     %s,BC", Rx); break;
-                     case 0031: Gen("ADD     %s,DE", Rx); break;
-                     case 0051: Gen("ADD     %s,%s", Rx, Rx); break;
-                     case 0071: Gen("ADD     %s,SP", Rx); break;
-                     case 0041: Gen("LD      %s,$%4.4X", Rx, GetW(IP)); break;
-                     case 0042: Gen("LD      ($%4.4X),%s", GetW(IP), Rx); break;
-                     case 0052: Gen("LD      %s,($%4.4X)", Rx, GetW(IP)); break;
-                     case 0043: Gen("INC     %s", Rx); break;
-                     case 0053: Gen("DEC     %s", Rx); break;
-                     case 0044: Gen("INC     %sH", Rx); break;
-                     case 0045: Gen("DEC     %sH", Rx); break;
-                     case 0046: Gen("LD      %sH,$%2.2X", Rx, GetB(IP)); break;
-                     case 0054: Gen("INC     %sL", Rx); break;
-                     case 0055: Gen("DEC     %sL", Rx); break;
-                     case 0056: Gen("LD      %sL,$%2.2X", Rx, GetB(IP)); break;
-                     case 0064: Ds = GetDs(IP), Ds >= 0? Gen("INC     (%s+$%2.2X)", Rx, Ds): Gen("INC     (%s-$%2.2X)", Rx, -Ds); break;
-                     case 0065: Ds = GetDs(IP), Ds >= 0? Gen("DEC     (%s+$%2.2X)", Rx, Ds): Gen("DEC     (%s-$%2.2X)", Rx, -Ds); break;
-                     case 0066: Ds = GetDs(IP), Ds >= 0? Gen("LD      (%s+$%2.2X),$%2.2X", Rx, Ds, GetB(IP)): Gen("LD      (%s-$%2.2X),$%2.2X", Rx, -Ds, GetB(IP)); break;
-                     case 0144: case 0154: Gen("LD      %s%s,%sH", Rx, Rb[Y], Rx); break;
-                     case 0145: case 0155: Gen("LD      %s%s,%sL", Rx, Rb[Y], Rx); break;
-                     case 0104: case 0114: case 0124: case 0134: case 0174: Gen("LD      %s,%sH", Rb[Y], Rx); break;
-                     case 0105: case 0115: case 0125: case 0135: case 0175: Gen("LD      %s,%sL", Rb[Y], Rx); break;
-                     case 0106: case 0116: case 0126: case 0136: case 0146: case 0156: case 0176:
-                        Ds = GetDs(IP), Ds >= 0? Gen("LD      %s,(%s+$%2.2X)", Rb[Y], Rx, Ds): Gen("LD      %s,(%s-$%2.2X)", Rb[Y], Rx, -Ds);
-                     break;
-                     case 0140: case 0141: case 0142: case 0143: case 0147: Gen("LD      %sH,%s", Rx, Rb[Y]); break;
-                     case 0150: case 0151: case 0152: case 0153: case 0157: Gen("LD      %sL,%s", Rx, Rb[Y]); break;
-                     case 0160: case 0161: case 0162: case 0163: case 0164: case 0165: case 0167:
-                        Ds = GetDs(IP), Ds >= 0? Gen("LD      (%s+$%2.2X),%s", Rx, Ds, Rb[Z]): Gen("LD      (%s-$%2.2X),%s", Rx, -Ds, Rb[Z]);
-                     break;
-                     case 0204: case 0214: case 0224: case 0234: case 0244: case 0254: case 0264: case 0274: Gen("%-8s%sH", AOp[Y], Rx); break;
-                     case 0205: case 0215: case 0225: case 0235: case 0245: case 0255: case 0265: case 0275: Gen("%-8s%sL", AOp[Y], Rx); break;
-                     case 0206: case 0216: case 0226: case 0236: case 0246: case 0256: case 0266: case 0276:
-                        Ds = GetDs(IP), Ds >= 0? Gen("%-8s(%s+$%2.2X)", AOp[Y], Rx, Ds): Gen("%-8s(%s-$%2.2X)", AOp[Y], Rx, -Ds);
-                     break;
-                     case 0341: Gen("POP     %s", Rx); break;
-                     case 0343: Gen("EX      (SP),%s", Rx); break;
-                     case 0345: Gen("PUSH    %s", Rx); break;
-                     case 0351: Gen("JP      (%s)", Rx); break;
-                     case 0371: Gen("LD      SP,%s", Rx); break;
-                     case 0313:
-                        Ds = GetDs(IP);
-                        Op = GetB(IP), X = (Op >> 6)&3, Y = (Op >> 3)&7, Z = Op&7; // Fetch the tertiary opcode.
-                        switch (Z) {
-                           default: switch (X) {
-                              case 0: Ds >= 0? Gen("%-8s(%s+$%2.2X),%s", ShOp[Y], Rx, Ds, Rb[X]): Gen("%-8s(%s-$%2.2X),%s", ShOp[Y], Rx, -Ds, Rb[X]); break;
-                              case 1: Ds >= 0? Gen("BIT     %d,(%s+$%2.2X),%s", Y, Rx, Ds, Rb[X]): Gen("BIT     %d,(%s-$%2.2X),%s", Y, Rx, -Ds, Rb[X]); break;
-                              case 2: Ds >= 0? Gen("RES     %d,(%s+$%2.2X),%s", Y, Rx, Ds, Rb[X]): Gen("RES     %d,(%s-$%2.2X),%s", Y, Rx, -Ds, Rb[X]); break;
-                              case 3: Ds >= 0? Gen("SET     %d,(%s+$%2.2X),%s", Y, Rx, Ds, Rb[X]): Gen("SET     %d,(%s-$%2.2X),%s", Y, Rx, -Ds, Rb[X]); break;
-                           }
-                           break;
-                           case 6: switch (X) {
-                              case 0: Ds >= 0? Gen("%-8s(%s+$%2.2X)", ShOp[Y], Rx, Ds): Gen("%-8s(%s-$%2.2X)", ShOp[Y], Rx, -Ds); break;
-                              case 1: Ds >= 0? Gen("BIT     %d,(%s+$%2.2X)", Y, Rx, Ds): Gen("BIT     %d,(%s-$%2.2X)", Y, Rx, -Ds); break;
-                              case 2: Ds >= 0? Gen("RES     %d,(%s+$%2.2X)", Y, Rx, Ds): Gen("RES     %d,(%s-$%2.2X)", Y, Rx, -Ds); break;
-                              case 3: Ds >= 0? Gen("SET     %d,(%s+$%2.2X)", Y, Rx, Ds): Gen("SET     %d,(%s-$%2.2X)", Y, Rx, -Ds); break;
-                           }
-                           break;
-                        }
-                     break;
-                  }
-               }
-               break;
+         case 0166: if (In && Why == NoBlock) Why = IP; if (In && Full) AddNote(IP, "halt: unbounded"); break;
+         case 0004: case 0005: case 0020: RB = -1; break;		// inc B, dec B, djnz
+         case 0014: case 0015: RC = -1; break;				// inc C, dec C
+         case 0301: case 0331: RB = RC = -1; break;			// pop BC, exx
+         default: if (Op >= 0100 && Op < 0110) RB = -1; else if (Op >= 0110 && Op < 0120) RC = -1; break;
+      } else if (Page == PgCB || Page == PgDDCB || Page == PgFDCB) {
+         if (Op >> 6 != 1 && (Op&7) == 0) RB = -1; else if (Op >> 6 != 1 && (Op&7) == 1) RC = -1;
+      } else if (Page == PgED) {
+         if (Op >> 6 == 2) RB = RC = -1;
+         else if (Op == 0100) RB = -1; else if (Op == 0110) RC = -1; else if (Op == 0113) RB = RC = -1;
+      } else if (Op >= 0100 && Op < 0110) RB = -1; else if (Op >= 0110 && Op < 0120) RC = -1;
+   }
+   if (Full) {
+   // A routine called or restarted may change B.
+      int Flow = DcFlags[Blocks[Bl].Last]&DcFlow;
+      BlockB[Bl] = Flow == FlCall || Flow == FlRst? -1: RB;
+   }
+   return T;
+}
+
+// Whether the edge E out of the block From is followed in the search with the stamp S and without the edges into Cut.
+static inline bool Follow(uint32_t From, const Edge &E, uint32_t S, uint32_t Cut) {
+   return InRoutine(E.Kind) && E.To != NoBlock && E.To != Cut && Mark[E.To] == S && (Closed == nullptr || !Closed[From]);
+}
+
+// The strongly connected components of the blocks marked with the stamp S and reached from Head, without the edges into Cut,
+// by Tarjan's algorithm without recursion, into Comp[CompFirst[C]] to Comp[CompFirst[C + 1] - 1], in reverse topological order;
+// return their number.
+static uint32_t FindComps(uint32_t Head, uint32_t S, uint32_t Cut, uint32_t *Comp, uint32_t *CompFirst) {
+   struct Frame { uint32_t B, O; };
+   static Frame *Frames; static uint32_t *Stack, FrameMax;
+   if (FrameMax < BlockN + 1) {
+      FrameMax = BlockN + 1;
+      Frames = (Frame *)realloc(Frames, FrameMax*sizeof *Frames), Stack = (uint32_t *)realloc(Stack, FrameMax*sizeof *Stack);
+      if (Frames == nullptr || Stack == nullptr) exit(1);
+   }
+   uint32_t FrameN = 0, StackN = 0, VisitN = 0, CompN = 0, CompAt = 0;
+   for (uint32_t B = Head; ; ) {
+      Seen[B] = S, Visit[B] = Low[B] = VisitN++, CompOf[B] = NoBlock, Stack[StackN++] = B, Frames[FrameN++] = Frame{ B, OutFirst[B] };
+      for (B = NoBlock; FrameN > 0 && B == NoBlock; ) {
+         Frame &F = Frames[FrameN - 1];
+         if (F.O < OutFirst[F.B + 1]) {
+            const Edge &E = Edges[OutEdge[F.O++]];
+            if (!Follow(F.B, E, S, Cut)) ;
+            else if (Seen[E.To] != S) B = E.To;
+            else if (CompOf[E.To] == NoBlock && Visit[E.To] < Low[F.B]) Low[F.B] = Visit[E.To];
+            continue;
+         }
+         uint32_t Top = F.B; FrameN--;
+         if (FrameN > 0 && Low[Top] < Low[Frames[FrameN - 1].B]) Low[Frames[FrameN - 1].B] = Low[Top];
+         if (Low[Top] != Visit[Top]) continue;
+         CompFirst[CompN] = CompAt;
+         do Comp[CompAt] = Stack[--StackN], CompOf[Comp[CompAt]] = CompN; while (Comp[CompAt++] != Top);
+         CompN++;
+      }
+      if (B == NoBlock) break;
+   }
+   CompFirst[CompN] = CompAt;
+   return CompN;
+}
+
+static const uint32_t TraceLoop = 0x80000000;	// In a trace: the block is the head of a loop.
+
+// The longest path through the blocks Set[0] to Set[SetN - 1] from Head, without the edges into Cut, or NoTime;
+// Why is set to the address that leaves it unbounded, if it is not already set.
+// If Trace is given, the blocks of the path are put into it (the head of each loop, with TraceLoop) and TraceN is set to their number.
+static uint64_t LongestPath(const uint32_t *Set, uint32_t SetN, uint32_t Head, uint32_t Cut, uint32_t &Why, uint32_t *Trace = nullptr, uint32_t *TraceN = nullptr) {
+   uint32_t S = ++Stamp;
+   for (uint32_t K = 0; K < SetN; K++) Mark[Set[K]] = S;
+   uint32_t *Comp = (uint32_t *)malloc((SetN + 1)*sizeof *Comp), *CompFirst = (uint32_t *)malloc((SetN + 2)*sizeof *CompFirst);
+   if (Comp == nullptr || CompFirst == nullptr) exit(1);
+   uint32_t CompN = FindComps(Head, S, Cut, Comp, CompFirst);
+   uint64_t *Cost = (uint64_t *)malloc((CompN + 1)*sizeof *Cost), *Dist = (uint64_t *)malloc((CompN + 1)*sizeof *Dist);
+   uint32_t *Pred = (uint32_t *)malloc((CompN + 1)*sizeof *Pred), *Rep = (uint32_t *)malloc((CompN + 1)*sizeof *Rep);
+   if (Cost == nullptr || Dist == nullptr || Pred == nullptr || Rep == nullptr) exit(1);
+// The cost of each component: that of its block, or of the loop.
+   for (uint32_t C = 0; C < CompN; C++) {
+      const uint32_t *CP = Comp + CompFirst[C]; uint32_t CN = CompFirst[C + 1] - CompFirst[C], B = CP[0];
+      bool Loop = CN > 1;
+      for (uint32_t O = OutFirst[B]; O < OutFirst[B + 1]; O++) if (Edges[OutEdge[O]].To == B && Follow(B, Edges[OutEdge[O]], S, Cut)) Loop = true;
+      Rep[C] = B;
+      if (!Loop) { Cost[C] = BlockCost[B]; if (Cost[C] == NoTime && Why == NoBlock) Why = BlockWhy[B]; continue; }
+   // The head, the only block entered from outside of the loop, and the passes, by the value of B in each block that enters it.
+      uint32_t LoopHead = NoBlock; int Passes = 0; bool Bounded = true;
+      for (uint32_t K = 0; K < CN; K++) if (CP[K] == Head) LoopHead = Head, Passes = 0x100;
+      for (uint32_t K = 0; K < SetN; K++) {
+         uint32_t U = Set[K]; if (Seen[U] != S || CompOf[U] == C) continue;
+         for (uint32_t O = OutFirst[U]; O < OutFirst[U + 1]; O++) {
+            const Edge &E = Edges[OutEdge[O]];
+            if (!Follow(U, E, S, Cut) || CompOf[E.To] != C) continue;
+            if (LoopHead != NoBlock && LoopHead != E.To) Bounded = false;
+            int N = BlockB[U] <= 0? 0x100: BlockB[U];
+            LoopHead = E.To; if (N > Passes) Passes = N;
+         }
+      }
+      Rep[C] = LoopHead | TraceLoop;
+   // The edges back to the head: all from djnz.
+      for (uint32_t K = 0; K < CN && Bounded; K++) for (uint32_t O = OutFirst[CP[K]]; O < OutFirst[CP[K] + 1]; O++) {
+         const Edge &E = Edges[OutEdge[O]];
+         if (E.To == LoopHead && Follow(CP[K], E, S, Cut) && (E.Kind != EdCond || DcOp[Blocks[CP[K]].Last] != 0020)) Bounded = false;
+      }
+      if (!Bounded) {
+         Cost[C] = NoTime; if (Why == NoBlock) Why = Blocks[LoopHead].Lo;
+         if (LoopNotes) AddNote(Blocks[LoopHead].Lo, "loop: unbounded");
+         continue;
+      }
+      uint64_t Pass = LongestPath(CP, CN, LoopHead, LoopHead, Why);
+   // Restore what the nested search overwrote.
+      for (uint32_t K = 0; K < SetN; K++) Mark[Set[K]] = S;
+      for (uint32_t K = 0; K < CN; K++) Seen[CP[K]] = S, CompOf[CP[K]] = C;
+      Cost[C] = Pass == NoTime? NoTime: Pass*Passes;
+      if (LoopNotes) AddNote(Blocks[LoopHead].Lo, "loop: at most %d passes", Passes);
+   }
+// The longest path over the components, in topological order: that of Head is the last one.
+   for (uint32_t C = 0; C < CompN; C++) Dist[C] = 0, Pred[C] = NoBlock;
+   Dist[CompN - 1] = Cost[CompN - 1];
+   uint32_t End = CompN - 1;
+   for (uint32_t C = CompN; C-- > 0; ) {
+      if (Dist[C] > Dist[End]) End = C;
+      for (uint32_t K = CompFirst[C]; K < CompFirst[C + 1]; K++) for (uint32_t O = OutFirst[Comp[K]]; O < OutFirst[Comp[K] + 1]; O++) {
+         const Edge &E = Edges[OutEdge[O]];
+         if (!Follow(Comp[K], E, S, Cut) || CompOf[E.To] == C) continue;
+         uint32_t To = CompOf[E.To]; uint64_t D = AddTime(Dist[C], Cost[To]);
+         if (D > Dist[To]) Dist[To] = D, Pred[To] = C;
+      }
+   }
+   uint64_t Worst = Dist[End];
+   if (Trace != nullptr) {
+      uint32_t N = 0;
+      for (uint32_t C = End; C != NoBlock; C = Pred[C]) Trace[N++] = Rep[C];
+      for (uint32_t K = 0; K < N/2; K++) { uint32_t T = Trace[K]; Trace[K] = Trace[N - 1 - K], Trace[N - 1 - K] = T; }
+      *TraceN = N;
+   }
+   free(Comp), free(CompFirst), free(Cost), free(Dist), free(Pred), free(Rep);
+   return Worst;
+}
+
+// Visit each routine after all of those that it calls or enters that are not being visited, by a depth-first search without recursion.
+static void EachRoutine(void (*VisitRoutine)(uint32_t R)) {
+   struct Frame { uint32_t R, K, O; } *Frames = (Frame *)malloc((BlockN + 1)*sizeof *Frames);
+   if (Frames == nullptr) exit(1);
+   memset(RoutineState, 0, BlockN + 1), RoutineN = 0;
+   for (uint32_t R0 = 0; R0 < BlockN; R0++) {
+      if (Blocks[R0].Owner != R0 || RoutineState[R0] != 0) continue;
+      uint32_t FrameN = 0; RoutineState[R0] = 1, Frames[FrameN++] = Frame{ R0, RoutineFirst[R0], OutFirst[RoutineBlock[RoutineFirst[R0]]] };
+      while (FrameN > 0) {
+         Frame &F = Frames[FrameN - 1]; uint32_t Next = NoBlock;
+         while (F.K < RoutineFirst[F.R + 1] && Next == NoBlock) {
+            uint32_t B = RoutineBlock[F.K];
+            if (F.O >= OutFirst[B + 1]) { if (++F.K < RoutineFirst[F.R + 1]) F.O = OutFirst[RoutineBlock[F.K]]; continue; }
+            const Edge &E = Edges[OutEdge[F.O++]];
+            if (E.To != NoBlock && Blocks[E.To].Owner != F.R && RoutineState[Blocks[E.To].Owner] == 0) Next = Blocks[E.To].Owner;
+         }
+         if (Next != NoBlock) { RoutineState[Next] = 1, Frames[FrameN++] = Frame{ Next, RoutineFirst[Next], OutFirst[RoutineBlock[RoutineFirst[Next]]] }; continue; }
+         VisitRoutine(F.R), RoutineState[F.R] = 2, Routines[RoutineN++] = F.R, FrameN--;
+      }
+   }
+   free(Frames);
+}
+
+// Bound the routine R.
+static void TimeRoutine(uint32_t R) {
+   for (uint32_t K = RoutineFirst[R]; K < RoutineFirst[R + 1]; K++) {
+      uint32_t B = RoutineBlock[K], Why = Loose[B]; uint64_t Cost = Why != NoBlock? NoTime: BlockTime[B];
+      for (uint32_t O = OutFirst[B]; O < OutFirst[B + 1]; O++) {
+         const Edge &E = Edges[OutEdge[O]];
+         if (E.To == NoBlock || InRoutine(E.Kind) && Blocks[E.To].Owner == R) continue;
+         uint32_t To = Blocks[E.To].Owner;
+         if (RoutineState[To] != 2) AddNote(Blocks[B].Last, "recursion");
+         uint64_t T = RoutineState[To] == 2? RoutineTime[To]: NoTime;
+         if (T == NoTime && Why == NoBlock) Why = Blocks[B].Last;
+         Cost = AddTime(Cost, T);
+      }
+      BlockCost[B] = Cost, BlockWhy[B] = Why;
+   }
+   RoutineWhy[R] = NoBlock, RoutineTime[R] = LongestPath(RoutineBlock + RoutineFirst[R], RoutineFirst[R + 1] - RoutineFirst[R], R, NoBlock, RoutineWhy[R]);
+   if (RoutineTime[R] != NoTime) AddNote(Blocks[R].Lo, "routine: at most %llu T", (unsigned long long)RoutineTime[R]);
+   else AddNote(Blocks[R].Lo, "routine: unbounded, at %s", BlockName(RoutineWhy[R]));
+}
+
+// For -i: the T-states of the routines that the block B, of the routine R, calls or enters, with the interrupts disabled;
+// close the block, if it calls a routine that always enables them.
+static uint64_t OffCalls(uint32_t B, uint32_t R) {
+   uint64_t Cost = 0;
+   for (uint32_t O = OutFirst[B]; O < OutFirst[B + 1]; O++) {
+      const Edge &E = Edges[OutEdge[O]];
+      if (E.To == NoBlock || InRoutine(E.Kind) && Blocks[E.To].Owner == R) continue;
+      uint32_t To = Blocks[E.To].Owner;
+      Cost = AddTime(Cost, RoutineState[To] == 2? RoutineTime[To]: NoTime);
+      if (RoutineState[To] == 2 && !RoutineKeeps[To] && !InRoutine(E.Kind)) Closed[B] = true;
+   }
+   return Cost;
+}
+
+// For -i: set the cost of the span of the block B, of the routine R, from Lo to Hi, with the calls out of it, if it is not closed.
+static void OffCost(uint32_t B, uint32_t R, uint32_t Lo, uint32_t Hi) {
+   uint32_t Why = NoBlock; uint64_t T = Hi >= Lo? TimeSpan(B, Lo, Hi, Why, false): 0;
+   if (Why != NoBlock) T = NoTime;
+   if (!Closed[B]) {
+      uint64_t C = OffCalls(B, R);
+      if (C == NoTime && Why == NoBlock) Why = Blocks[B].Last;
+      T = AddTime(T, C);
+   }
+   BlockCost[B] = T, BlockWhy[B] = Why;
+}
+
+// For -i: whether a path from the block Head of the routine R, with the interrupts disabled, returns or enters a routine that may return.
+static bool OffReturns(uint32_t R, uint32_t Head) {
+   uint32_t S = ++Stamp, WorkN = 0; bool Returns = false;
+   Seen[Head] = S, Work[WorkN++] = Head;
+   while (WorkN > 0 && !Returns) {
+      uint32_t B = Work[--WorkN]; if (Closed[B]) continue;
+      for (uint32_t O = OutFirst[B]; O < OutFirst[B + 1]; O++) {
+         const Edge &E = Edges[OutEdge[O]];
+         if (E.Kind == EdRet) Returns = true;
+         else if (!InRoutine(E.Kind) || E.To == NoBlock) ;
+         else if (Blocks[E.To].Owner != R) { if (RoutineState[Blocks[E.To].Owner] == 2 && RoutineKeeps[Blocks[E.To].Owner]) Returns = true; }
+         else if (Seen[E.To] != S) Seen[E.To] = S, Work[WorkN++] = E.To;
+      }
+   }
+   return Returns;
+}
+
+// For -i: bound the routine R from its entry up to its returns or its opcodes that enable the interrupts.
+static void OffRoutine(uint32_t R) {
+   for (uint32_t K = RoutineFirst[R]; K < RoutineFirst[R + 1]; K++) {
+      uint32_t B = RoutineBlock[K];
+      Closed[B] = EnAt[B] != NoBlock;
+      if (Closed[B]) OffCost(B, R, Blocks[B].Lo, EnAt[B]); else OffCost(B, R, Blocks[B].Lo, Blocks[B].Last);
+   }
+   RoutineWhy[R] = NoBlock, RoutineTime[R] = LongestPath(RoutineBlock + RoutineFirst[R], RoutineFirst[R + 1] - RoutineFirst[R], R, NoBlock, RoutineWhy[R]);
+   RoutineKeeps[R] = OffReturns(R, R);
+}
+
+// For -i: a region from a di.
+struct OffRegion {
+   uint16_t At; uint64_t T; uint32_t Why; bool Open;
+   uint32_t Trace, TraceN;	// Its path: Traces[Trace] to Traces[Trace + TraceN - 1].
+};
+
+static OffRegion *Regions; static uint32_t RegionN, RegionMax;
+static uint32_t *Traces; static uint32_t TraceAt, TraceMax;
+
+// For -i: bound the region from the di at IP, in the block B.
+static void OffFrom(uint16_t IP, uint32_t B) {
+   uint32_t R = Blocks[B].Owner, SetN = RoutineFirst[R + 1] - RoutineFirst[R];
+   uint64_t Cost0 = BlockCost[B]; uint32_t Why0 = BlockWhy[B]; bool Closed0 = Closed[B];
+// The head: the span after the di, up to the next opcode that enables the interrupts, if any.
+   uint32_t Hi = Blocks[B].Last;
+   for (uint32_t Op = IP + DcLen[IP]; Op <= Blocks[B].Last; Op += DcLen[Op]) if (Enables(Op)) { Hi = Op; break; }
+   Closed[B] = Hi > IP && Enables(Hi), OffCost(B, R, IP + DcLen[IP], Hi);
+   if (RegionN >= RegionMax) {
+      RegionMax = RegionMax == 0? 0x40: 2*RegionMax;
+      Regions = (OffRegion *)realloc(Regions, RegionMax*sizeof *Regions); if (Regions == nullptr) exit(1);
+   }
+   if (TraceAt + SetN > TraceMax) {
+      TraceMax = 2*(TraceAt + SetN) > 0x400? 2*(TraceAt + SetN): 0x400;
+      Traces = (uint32_t *)realloc(Traces, TraceMax*sizeof *Traces); if (Traces == nullptr) exit(1);
+   }
+   OffRegion &Rg = Regions[RegionN++];
+   Rg.At = IP, Rg.Why = NoBlock, Rg.Trace = TraceAt;
+   Rg.T = LongestPath(RoutineBlock + RoutineFirst[R], SetN, B, NoBlock, Rg.Why, Traces + TraceAt, &Rg.TraceN);
+   Rg.Open = OffReturns(R, B), TraceAt += Rg.TraceN;
+   if (Rg.T != NoTime) AddNote(IP, "interrupts off: at most %llu T%s", (unsigned long long)Rg.T, Rg.Open? ", open at the return": "");
+   else AddNote(IP, "interrupts off: unbounded, at %s", BlockName(Rg.Why));
+   BlockCost[B] = Cost0, BlockWhy[B] = Why0, Closed[B] = Closed0;
+}
+
+// For -d: the stack depth, in bytes pushed since the entry of the routine, by block and by routine.
+static const uint32_t NoDepth = ~0U;	// Unbounded, by recursion.
+static int32_t *DepthIn;	// The depth at the start of each block.
+static uint32_t *RoutineDepth;	// The deepest that the routine at each block goes, with the routines that it calls, or NoDepth.
+static uint32_t *DeepCall;	// The routine that it calls or enters on its deepest path, or NoBlock.
+static uint32_t *Unbalanced;	// The address at which its stack, or that of a routine that it calls, is unbalanced, or NoBlock.
+static uint32_t *Recursion;	// The address of its call that leads to recursion, or NoBlock.
+
+// For -d: the change of the stack depth by the opcode at IP, or Reset, if it loads SP.
+static const int Reset = 0x100;
+static int StackMove(uint16_t IP) {
+   unsigned Page = DcOp[IP] >> 8, Op = DcOp[IP]&0xff;
+   switch (Page) {
+      case PgBase: return (Op&0317) == 0305? +2: (Op&0317) == 0301? -2: Op == 0063? -1: Op == 0073? +1: Op == 0061 || Op == 0371? Reset: 0;
+      case PgDD: case PgFD: return Op == 0345? +2: Op == 0341? -2: Op == 0371? Reset: 0;
+      case PgED: return Op == 0173? Reset: 0;
+      default: return 0;
+   }
+}
+
+// For -d: bound the stack depth of the routine R, by following its blocks from its entry, with the depth at the start of each.
+// A block reached at two different depths, or a return at a depth other than 0, leaves the stack unbalanced.
+// A load of SP starts a new stack, at the depth 0.
+static void DepthRoutine(uint32_t R) {
+   uint32_t S = ++Stamp, WorkN = 0, Call = NoBlock, Bad = NoBlock, RecAt = NoBlock; int32_t Deep = 0;
+   Seen[R] = S, DepthIn[R] = 0, Work[WorkN++] = R;
+   while (WorkN > 0) {
+      uint32_t B = Work[--WorkN]; int32_t D = DepthIn[B];
+      for (uint32_t IP = Blocks[B].Lo; IP <= Blocks[B].Last; IP += DcLen[IP]) {
+         int Move = StackMove(IP);
+         if (Move == Reset) D = 0; else if ((D += Move) > Deep) Deep = D;
+      }
+      for (uint32_t O = OutFirst[B]; O < OutFirst[B + 1]; O++) {
+         const Edge &E = Edges[OutEdge[O]];
+         if (E.Kind == EdRet) {
+            if (D != 0 && Bad == NoBlock) Bad = Blocks[B].Last, AddNote(Bad, "stack: unbalanced, %d bytes at the return", D);
+         } else if (E.To == NoBlock) ;
+         else if (!InRoutine(E.Kind) || Blocks[E.To].Owner != R) {
+         // A call pushes the address to return to; a jump into another routine does not.
+            uint32_t To = Blocks[E.To].Owner; int32_t At = D + (InRoutine(E.Kind)? 0: 2);
+            if (RoutineState[To] != 2 || RoutineDepth[To] == NoDepth) { if (RecAt == NoBlock) RecAt = Blocks[B].Last; continue; }
+            if (At + int32_t(RoutineDepth[To]) > Deep) Deep = At + RoutineDepth[To], Call = To;
+            if (Unbalanced[To] != NoBlock && Bad == NoBlock) Bad = Unbalanced[To];
+         } else if (Seen[E.To] != S) Seen[E.To] = S, DepthIn[E.To] = D, Work[WorkN++] = E.To;
+         else if (DepthIn[E.To] != D && Bad == NoBlock) Bad = Blocks[E.To].Lo, AddNote(Bad, "stack: unbalanced, %d or %d bytes here", DepthIn[E.To], D);
+      }
+   }
+   RoutineDepth[R] = RecAt != NoBlock? NoDepth: Deep, DeepCall[R] = Call, Unbalanced[R] = Bad, Recursion[R] = RecAt;
+   if (RecAt != NoBlock) AddNote(Blocks[R].Lo, "stack: unbounded, by recursion at %s", BlockName(RecAt));
+   else AddNote(Blocks[R].Lo, "stack: at most %d bytes", Deep);
+}
+
+// For -d: write the depth of the routine R and its deepest call chain to ExF.
+static void PutDepth(FILE *ExF, uint32_t R) {
+   fprintf(ExF, ";       %-16s", BlockName(Blocks[R].Lo));
+   if (RoutineDepth[R] == NoDepth) { fprintf(ExF, " unbounded, by recursion at %s\n", BlockName(Recursion[R])); return; }
+   fprintf(ExF, " %u", RoutineDepth[R]);
+   if (Unbalanced[R] != NoBlock) fprintf(ExF, ", unbalanced at %s", BlockName(Unbalanced[R]));
+   fprintf(ExF, ":");
+   for (uint32_t C = R; C != NoBlock; C = DeepCall[C]) fprintf(ExF, "%s%s", C != R? " > ": " ", BlockName(Blocks[C].Lo));
+   fprintf(ExF, "\n");
+}
+
+// The longest region first, then by address.
+static int CompareRegion(const void *A, const void *B) {
+   const OffRegion *RA = (const OffRegion *)A, *RB = (const OffRegion *)B;
+   if (RA->T != RB->T) return RA->T > RB->T? -1: +1;
+   return RA->At < RB->At? -1: +1;
+}
+
+// Unbounded first, then by decreasing worst case, then by address.
+static int CompareTime(const void *A, const void *B) {
+   uint32_t RA = *(const uint32_t *)A, RB = *(const uint32_t *)B;
+   if (RoutineTime[RA] != RoutineTime[RB]) return RoutineTime[RA] > RoutineTime[RB]? -1: +1;
+   return RA < RB? -1: +1;
+}
+
+// Bound the routines of the current view, entered at Entry: their T-states (-t), the regions with the interrupts disabled (-i) and their stack depth (-d);
+// note the bounds on the lines and write the reports, as comments, to ExF.
+static void BoundRoutines(FILE *ExF, uint32_t Entry, bool DoTime, bool DoOff, bool DoDepth) {
+   ClearNotes();
+   uint32_t N = BlockN + 1;
+   BlockTime = (uint64_t *)malloc(N*sizeof *BlockTime), BlockCost = (uint64_t *)malloc(N*sizeof *BlockCost), RoutineTime = (uint64_t *)malloc(N*sizeof *RoutineTime);
+   BlockB = (int16_t *)malloc(N*sizeof *BlockB), Loose = (uint32_t *)malloc(N*sizeof *Loose), BlockWhy = (uint32_t *)malloc(N*sizeof *BlockWhy), RoutineWhy = (uint32_t *)malloc(N*sizeof *RoutineWhy);
+   RoutineState = (uint8_t *)calloc(N, sizeof *RoutineState), Mark = (uint32_t *)calloc(N, sizeof *Mark), Seen = (uint32_t *)calloc(N, sizeof *Seen);
+   Visit = (uint32_t *)malloc(N*sizeof *Visit), Low = (uint32_t *)malloc(N*sizeof *Low), CompOf = (uint32_t *)malloc(N*sizeof *CompOf);
+   RoutineBlock = (uint32_t *)malloc(N*sizeof *RoutineBlock), RoutineFirst = (uint32_t *)calloc(N + 1, sizeof *RoutineFirst), Routines = (uint32_t *)malloc(N*sizeof *Routines);
+   uint32_t *At = (uint32_t *)malloc(N*sizeof *At); Work = (uint32_t *)malloc(N*sizeof *Work);
+   if (BlockTime == nullptr || BlockCost == nullptr || RoutineTime == nullptr || BlockB == nullptr || Loose == nullptr || BlockWhy == nullptr || RoutineWhy == nullptr) exit(1);
+   if (RoutineState == nullptr || Mark == nullptr || Seen == nullptr || Visit == nullptr || Low == nullptr || CompOf == nullptr) exit(1);
+   if (RoutineBlock == nullptr || RoutineFirst == nullptr || Routines == nullptr || At == nullptr || Work == nullptr) exit(1);
+   Stamp = 0;
+   for (uint32_t B = 0; B < BlockN; B++) {
+      BlockTime[B] = TimeSpan(B, Blocks[B].Lo, Blocks[B].Last, Loose[B], true);
+      if (DoTime) AddNote(Blocks[B].Lo, "%llu T", (unsigned long long)BlockTime[B]);
+   }
+// The blocks of each routine, by counting sort.
+   for (uint32_t B = 0; B < BlockN; B++) RoutineFirst[Blocks[B].Owner + 1]++;
+   for (uint32_t B = 0; B < BlockN; B++) RoutineFirst[B + 1] += RoutineFirst[B], At[B] = RoutineFirst[B];
+   for (uint32_t B = 0; B < BlockN; B++) RoutineBlock[At[Blocks[B].Owner]++] = B;
+   free(At);
+   if (DoTime) {
+      LoopNotes = true, EachRoutine(TimeRoutine), LoopNotes = false;
+      qsort(Routines, RoutineN, sizeof *Routines, CompareTime);
+      fprintf(ExF, "; Worst-case T-states of the routines:\n");
+      for (uint32_t K = 0; K < RoutineN; K++) {
+         uint32_t R = Routines[K];
+         fprintf(ExF, ";       %-16s", BlockName(Blocks[R].Lo));
+         if (RoutineTime[R] != NoTime) fprintf(ExF, " %llu\n", (unsigned long long)RoutineTime[R]);
+         else fprintf(ExF, " unbounded, at %s\n", BlockName(RoutineWhy[R]));
+      }
+   }
+   if (DoOff) {
+      Closed = (uint8_t *)calloc(N, sizeof *Closed), EnAt = (uint32_t *)malloc(N*sizeof *EnAt);
+      RoutineKeeps = (uint8_t *)calloc(N, sizeof *RoutineKeeps);
+      if (Closed == nullptr || EnAt == nullptr || RoutineKeeps == nullptr) exit(1);
+      for (uint32_t B = 0; B < BlockN; B++) {
+         EnAt[B] = NoBlock;
+         for (uint32_t IP = Blocks[B].Lo; IP <= Blocks[B].Last; IP += DcLen[IP]) if (Enables(IP)) { EnAt[B] = IP; break; }
+      }
+      EachRoutine(OffRoutine);
+      RegionN = TraceAt = 0;
+      for (uint32_t B = 0; B < BlockN; B++) for (uint32_t IP = Blocks[B].Lo; IP <= Blocks[B].Last; IP += DcLen[IP]) if (DcOp[IP] == 0363) OffFrom(IP, B);
+   // The report: the regions, each with its path.
+      OffRegion *Sorted = (OffRegion *)malloc((RegionN + 1)*sizeof *Sorted); if (Sorted == nullptr) exit(1);
+      if (RegionN > 0) memcpy(Sorted, Regions, RegionN*sizeof *Sorted);
+      qsort(Sorted, RegionN, sizeof *Sorted, CompareRegion);
+      fprintf(ExF, "; Worst-case T-states with the interrupts disabled, from each DI:\n");
+      for (uint32_t K = 0; K < RegionN; K++) {
+         const OffRegion &Rg = Sorted[K];
+         fprintf(ExF, ";       %-16s", BlockName(Rg.At));
+         if (Rg.T != NoTime) fprintf(ExF, " %llu", (unsigned long long)Rg.T); else fprintf(ExF, " unbounded, at %s", BlockName(Rg.Why));
+         if (Rg.Open) fprintf(ExF, ", open at the return");
+         fprintf(ExF, ":");
+         for (uint32_t P = 0; P < Rg.TraceN; P++) {
+            uint32_t B = Traces[Rg.Trace + P]&~TraceLoop, Lo = P > 0? Blocks[B].Lo: Rg.At;
+            fprintf(ExF, "%s%s", P > 0? " > ": " ", BlockName(Lo));
+            if (Traces[Rg.Trace + P]&TraceLoop) { fprintf(ExF, " (loop)"); continue; }
+         // The calls at its end, unless the interrupts are enabled before it.
+            bool Ends = false;
+            for (uint32_t IP = Lo; IP <= Blocks[B].Last; IP += DcLen[IP]) if (Enables(IP)) Ends = true;
+            if (Ends) continue;
+            for (uint32_t O = OutFirst[B]; O < OutFirst[B + 1]; O++) {
+               const Edge &E = Edges[OutEdge[O]];
+               if (E.To == NoBlock || InRoutine(E.Kind) && Blocks[E.To].Owner == Blocks[B].Owner) continue;
+               fprintf(ExF, " (%s %s)", InRoutine(E.Kind)? "into": "call", BlockName(Blocks[E.To].Lo));
             }
-            break;
          }
-         break;
-         case 6: Gen("%-8s$%2.2X", AOp[Y], GetB(IP)); break;
-         case 7: Gen("RST     $%2.2X", Op&070); break;
+         fprintf(ExF, "\n");
+      }
+      free(Sorted), free(Closed), free(EnAt), free(RoutineKeeps);
+      Closed = nullptr;
+   }
+   if (DoDepth) {
+      DepthIn = (int32_t *)malloc(N*sizeof *DepthIn), RoutineDepth = (uint32_t *)malloc(N*sizeof *RoutineDepth);
+      DeepCall = (uint32_t *)malloc(N*sizeof *DeepCall), Unbalanced = (uint32_t *)malloc(N*sizeof *Unbalanced), Recursion = (uint32_t *)malloc(N*sizeof *Recursion);
+      bool *Called = (bool *)calloc(N, sizeof *Called);
+      if (DepthIn == nullptr || RoutineDepth == nullptr || DeepCall == nullptr || Unbalanced == nullptr || Recursion == nullptr || Called == nullptr) exit(1);
+      EachRoutine(DepthRoutine);
+   // The entry points: the routines not called or entered by any other, and the vectors.
+      for (uint32_t E = 0; E < EdgeN; E++) {
+         const Edge &Ed = Edges[E];
+         if (Ed.To != NoBlock && Blocks[Ed.To].Owner != Blocks[Ed.From].Owner) Called[Blocks[Ed.To].Owner] = true;
+      }
+      auto Vector = [](uint32_t Addr) { uint32_t B = BlockOf[Addr]; return B != 0 && Blocks[B - 1].Lo == Addr && Blocks[B - 1].Owner == B - 1? B - 1: NoBlock; };
+      for (uint32_t IP = 0; IP < 0100; IP += 010) if (Vector(IP) != NoBlock) Called[Vector(IP)] = false;
+      if (Vector(0146) != NoBlock) Called[Vector(0146)] = false;
+      fprintf(ExF, "; Stack depth of the entry points, in bytes, with the deepest call chain:\n");
+      for (uint32_t R = 0; R < BlockN; R++) if (Blocks[R].Owner == R && !Called[R]) PutDepth(ExF, R);
+   // The maskable interrupt (in mode 1) and the NMI, nested on top of the program at the entry.
+      uint32_t Main = BlockOf[uint16_t(Entry)] != 0? Blocks[BlockOf[uint16_t(Entry)] - 1].Owner: NoBlock, Int = Vector(0070), Nmi = Vector(0146);
+      if (Main != NoBlock && Main != Int && Main != Nmi && (Int != NoBlock || Nmi != NoBlock)) {
+         uint32_t Total = RoutineDepth[Main];
+         for (uint32_t V: { Int, Nmi }) if (V != NoBlock) Total = Total == NoDepth || RoutineDepth[V] == NoDepth? NoDepth: Total + 2 + RoutineDepth[V];
+         fprintf(ExF, "; With the interrupt at %s nested on top of %s:", Int != NoBlock && Nmi != NoBlock? "0038 and the NMI at 0066": Int != NoBlock? "0038": "0066", BlockName(Blocks[Main].Lo));
+         if (Total == NoDepth) fprintf(ExF, " unbounded\n"); else fprintf(ExF, " %u\n", Total);
+      }
+      free(DepthIn), free(RoutineDepth), free(DeepCall), free(Unbalanced), free(Recursion), free(Called);
+   }
+   free(BlockTime), free(BlockCost), free(RoutineTime), free(BlockB), free(Loose), free(BlockWhy), free(RoutineWhy);
+   free(RoutineState), free(Mark), free(Seen), free(Visit), free(Low), free(CompOf);
+   free(RoutineBlock), free(RoutineFirst), free(Routines), free(Work);
+}
+
+// Differences.
+// ────────────
+// With -vFile, the routines of the image are matched with those of an older version of it in File, loaded at the same origin and parsed in the same way.
+// Each routine is summed up by two hashes: its shape, the blocks of its control flow graph with the kinds of the edges between them,
+// and its body, its opcodes with their operands, but for the addresses (the words and the targets of the relative jumps), which move from one version to the next.
+// The routines are then matched in passes, each in time linear in the routines and the calls (but for sorting):
+// first those whose body and shape are found once in each image, then those called in the same order by a pair already matched,
+// then those left whose shape alone is found once in each, and then again those called by them.
+// A pair is the same, if its bodies and shapes are and each of its addresses is, in turn, into a pair matched, at the same offset, or the same address outside of the routines;
+// else it is changed.
+// The routines left over were removed from the older image, or added to the newer one.
+static const uint32_t InData = NoBlock - 1;	// An address in the image, outside of the routines.
+
+struct DiffRef { uint32_t R; uint16_t Value; };	// An address: its routine and its offset into it, or else NoBlock and the address itself, or InData.
+struct DiffRoutine {
+   uint16_t Lo; uint32_t Size;		// Its entry and the bytes of its opcodes.
+   uint64_t Body, Shape;		// Its hashes.
+   uint32_t Ref, RefN, Call, CallN;	// Its addresses, Refs[Ref] to Refs[Ref + RefN - 1], and its callees, Calls[Call] to Calls[Call + CallN - 1].
+   uint32_t Match;			// The routine matched with it in the other image, or NoBlock.
+};
+struct DiffImage {
+   DiffRoutine *Rs; uint32_t RN;
+   DiffRef *Refs; uint32_t RefN;
+   uint32_t *Calls; uint32_t CallN;
+};
+static DiffImage Olds, News;	// The older image, of -v, and the current one.
+
+// FNV-1a, continued from H over the 4 bytes of X.
+static inline uint64_t Mix(uint64_t H, uint32_t X) {
+   for (int N = 0; N < 4; N++, X >>= 8) H = (H ^ (X&0xff))*0x100000001b3ULL;
+   return H;
+}
+
+// Sum up the routines of the current view, after BuildGraph(), into D.
+static void SumRoutines(DiffImage &D) {
+   uint32_t N = BlockN + 1;
+   uint32_t *RoutineOf = (uint32_t *)malloc(N*sizeof *RoutineOf), *First = (uint32_t *)calloc(N + 1, sizeof *First), *At = (uint32_t *)malloc(N*sizeof *At);
+   uint32_t *Order = (uint32_t *)malloc(N*sizeof *Order), *Ord = (uint32_t *)malloc(N*sizeof *Ord);
+   D.Rs = (DiffRoutine *)malloc(N*sizeof *D.Rs), D.Refs = (DiffRef *)malloc(CodeMax*sizeof *D.Refs), D.Calls = (uint32_t *)malloc((EdgeN + 1)*sizeof *D.Calls);
+   if (RoutineOf == nullptr || First == nullptr || At == nullptr || Order == nullptr || Ord == nullptr) exit(1);
+   if (D.Rs == nullptr || D.Refs == nullptr || D.Calls == nullptr) exit(1);
+// The routines, in the order of their entries, and the blocks of each, by counting sort, with the place of each block in its routine.
+   D.RN = D.RefN = D.CallN = 0;
+   for (uint32_t B = 0; B < BlockN; B++) if (Blocks[B].Owner == B) D.Rs[D.RN].Lo = Blocks[B].Lo, RoutineOf[B] = D.RN++;
+   for (uint32_t B = 0; B < BlockN; B++) RoutineOf[B] = RoutineOf[Blocks[B].Owner], First[RoutineOf[B] + 1]++;
+   for (uint32_t R = 0; R < D.RN; R++) First[R + 1] += First[R], At[R] = First[R];
+   for (uint32_t B = 0; B < BlockN; B++) { uint32_t R = RoutineOf[B]; Ord[B] = At[R] - First[R], Order[At[R]++] = B; }
+   for (uint32_t R = 0; R < D.RN; R++) {
+      DiffRoutine &Dr = D.Rs[R];
+      uint64_t Body = 0xcbf29ce484222325ULL, Shape = Mix(Body, First[R + 1] - First[R]);
+      Dr.Size = 0, Dr.Ref = D.RefN, Dr.Call = D.CallN, Dr.Match = NoBlock;
+      for (uint32_t K = First[R]; K < First[R + 1]; K++) {
+         uint32_t B = Order[K], OpN = 0;
+         Dr.Size += Blocks[B].End - Blocks[B].Lo;
+         for (uint32_t IP = Blocks[B].Lo; IP <= Blocks[B].Last; IP += DcLen[IP], OpN++) {
+            int Form = DcInfo(IP).Form;
+            Body = Mix(Body, DcOp[IP] << 8 | DcLen[IP]);
+            if (Form != FmW && Form != FmJ) { Body = Mix(Body, uint8_t(DcDs[IP]) << 8 | (DcImm[IP]&0xff)); continue; }
+            uint16_t W = DcImm[IP]; uint32_t T = BlockOf[W]; DiffRef &F = D.Refs[D.RefN++];
+            if (T != 0) F.R = RoutineOf[T - 1], F.Value = W - D.Rs[F.R].Lo;
+            else if (W >= LoRAM && W <= HiRAM) F.R = InData, F.Value = 0;
+            else F.R = NoBlock, F.Value = W;
+         }
+         Shape = Mix(Shape, OpN);
+         for (uint32_t O = OutFirst[B]; O < OutFirst[B + 1]; O++) {
+            const Edge &E = Edges[OutEdge[O]];
+            bool Inner = InRoutine(E.Kind) && E.To != NoBlock && RoutineOf[E.To] == R;
+            Shape = Mix(Shape, E.Kind << 24 | (Inner? Ord[E.To]: 0xffffff));
+            if ((E.Kind == EdCall || E.Kind == EdRst) && E.To != NoBlock) D.Calls[D.CallN++] = RoutineOf[E.To];
+         }
       }
-      break;
+      Dr.Body = Body, Dr.Shape = Shape, Dr.RefN = D.RefN - Dr.Ref, Dr.CallN = D.CallN - Dr.Call;
+   }
+   free(RoutineOf), free(First), free(At), free(Order), free(Ord);
+}
+
+// A key of a routine of either image, for sorting.
+struct DiffKey { uint64_t Key; uint32_t R; bool New; };
+
+static int CompareKey(const void *A, const void *B) {
+   const DiffKey *KA = (const DiffKey *)A, *KB = (const DiffKey *)B;
+   if (KA->Key != KB->Key) return KA->Key < KB->Key? -1: +1;
+   if (KA->New != KB->New) return KA->New? +1: -1;
+   return KA->R < KB->R? -1: KA->R > KB->R? +1: 0;
+}
+
+// Match the older routine O with the newer one N, and queue the pair up, to go on to their callees.
+static void Pair(uint32_t O, uint32_t N, uint32_t *Queue, uint32_t &QueueN) { Olds.Rs[O].Match = N, News.Rs[N].Match = O, Queue[QueueN++] = O; }
+
+// Match the routines left whose key, their body and shape, or their shape alone, is found once in each image.
+static void MatchUnique(bool ByShape, uint32_t *Queue, uint32_t &QueueN) {
+   DiffKey *Keys = (DiffKey *)malloc((Olds.RN + News.RN + 1)*sizeof *Keys); if (Keys == nullptr) exit(1);
+   uint32_t KeyN = 0;
+   for (int Side = 0; Side < 2; Side++) {
+      const DiffImage &D = Side == 0? Olds: News;
+      for (uint32_t R = 0; R < D.RN; R++) if (D.Rs[R].Match == NoBlock)
+         Keys[KeyN].Key = ByShape? D.Rs[R].Shape: D.Rs[R].Body ^ D.Rs[R].Shape*0x9e3779b97f4a7c15ULL, Keys[KeyN].R = R, Keys[KeyN++].New = Side == 1;
+   }
+   qsort(Keys, KeyN, sizeof *Keys, CompareKey);
+   for (uint32_t K = 0, L; K < KeyN; K = L) {
+      for (L = K + 1; L < KeyN && Keys[L].Key == Keys[K].Key; L++);
+      if (L - K == 2 && !Keys[K].New && Keys[K + 1].New) Pair(Keys[K].R, Keys[K + 1].R, Queue, QueueN);
+   }
+   free(Keys);
+}
+
+// Match the routines called by the pairs queued, from At on: their callees in the same order, where neither is yet matched,
+// if both make the same number of calls, or else if the callees have the same shape.
+static void MatchCallees(uint32_t *Queue, uint32_t &QueueN, uint32_t At) {
+   for (; At < QueueN; At++) {
+      const DiffRoutine &O = Olds.Rs[Queue[At]], &N = News.Rs[O.Match];
+      for (uint32_t K = 0; K < O.CallN && K < N.CallN; K++) {
+         uint32_t CO = Olds.Calls[O.Call + K], CN = News.Calls[N.Call + K];
+         if (Olds.Rs[CO].Match != NoBlock || News.Rs[CN].Match != NoBlock) continue;
+         if (O.CallN == N.CallN || Olds.Rs[CO].Shape == News.Rs[CN].Shape) Pair(CO, CN, Queue, QueueN);
+      }
+   }
+}
+
+// Whether the older routine O is the same as the newer one N, matched with it.
+static bool SameRoutine(const DiffRoutine &O, const DiffRoutine &N) {
+   if (O.Body != N.Body || O.Shape != N.Shape || O.RefN != N.RefN) return false;
+   for (uint32_t K = 0; K < O.RefN; K++) {
+      const DiffRef &A = Olds.Refs[O.Ref + K], &B = News.Refs[N.Ref + K];
+      if (A.Value != B.Value) return false;
+      if (A.R >= InData || B.R >= InData? A.R != B.R: Olds.Rs[A.R].Match != B.R) return false;
+   }
+   return true;
+}
+
+// Match the routines of the current view with those of the older image, summed up before; note the differences on the lines and write the report, as comments, to ExF.
+static void DiffRoutines(FILE *ExF, const char *File) {
+   SumRoutines(News);
+   uint32_t *Queue = (uint32_t *)malloc((Olds.RN + 1)*sizeof *Queue), QueueN = 0; if (Queue == nullptr) exit(1);
+   MatchUnique(false, Queue, QueueN), MatchCallees(Queue, QueueN, 0);
+   uint32_t At = QueueN; MatchUnique(true, Queue, QueueN), MatchCallees(Queue, QueueN, At);
+   free(Queue);
+   uint32_t SameN = 0, MovedN = 0, ChangedN = 0, RemovedN = 0, AddedN = 0;
+   bool *Same = (bool *)malloc((News.RN + 1)*sizeof *Same); if (Same == nullptr) exit(1);
+   for (uint32_t R = 0; R < News.RN; R++) {
+      const DiffRoutine &N = News.Rs[R];
+      Same[R] = N.Match != NoBlock && SameRoutine(Olds.Rs[N.Match], N);
+      if (N.Match == NoBlock) AddedN++;
+      else if (!Same[R]) ChangedN++;
+      else if (SameN++, Olds.Rs[N.Match].Lo != N.Lo) MovedN++;
+   }
+   for (uint32_t R = 0; R < Olds.RN; R++) if (Olds.Rs[R].Match == NoBlock) RemovedN++;
+   fprintf(ExF, "; Routines against %s: %u the same (%u of them moved), %u changed, %u removed, %u added:\n", File, SameN, MovedN, ChangedN, RemovedN, AddedN);
+   for (uint32_t R = 0; R < News.RN; R++) {
+      const DiffRoutine &N = News.Rs[R];
+      if (N.Match == NoBlock) {
+         fprintf(ExF, ";       %-16s added, %u bytes\n", BlockName(N.Lo), N.Size), AddNote(N.Lo, "added");
+         continue;
+      }
+      const DiffRoutine &O = Olds.Rs[N.Match];
+      if (!Same[R]) {
+         fprintf(ExF, ";       %-16s changed, was L%04X, %u bytes, now %u\n", BlockName(N.Lo), O.Lo, O.Size, N.Size), AddNote(N.Lo, "changed, was L%04X", O.Lo);
+      } else if (O.Lo != N.Lo) fprintf(ExF, ";       %-16s moved, was L%04X\n", BlockName(N.Lo), O.Lo), AddNote(N.Lo, "was L%04X", O.Lo);
    }
+   for (uint32_t R = 0; R < Olds.RN; R++) if (Olds.Rs[R].Match == NoBlock) fprintf(ExF, ";       L%04X            removed, %u bytes\n", Olds.Rs[R].Lo, Olds.Rs[R].Size);
+   free(Same);
+   for (DiffImage *D: { &Olds, &News }) free(D->Rs), free(D->Refs), free(D->Calls);
 }
 
 static void Usage(const char *Path) {
@@ -451,12 +2255,30 @@ static void Usage(const char *Path) {
    for (char Ch; (Ch = *Path++) != '\0'; ) if (Ch == '/' || Ch == '\\') App = Path;
    printf(
       "Usage:\n"
-      "  %s [-fXX] [-oXXXX] [-p] [-r] [-x] <InFile> [<OutFile>]\n"
+      "  %s [-fXX] [-oXXXX] [-sXXXX] [-bXXXX [-wXXXX]] [-p] [-r] [-g] [-eXXXX] [-kFile] [-mFile] [-cFile] [-cpu 8080|8085|8088] [-t] [-i] [-d] [-a] [-x] [-yFile] [-vFile] [-jN] <InFile>|- [<OutFile>]\n"
       "    -fXX    fill unused memory, XX = 0x00 .. 0xff\n"
-      "    -oXXXX  org XXXX = 0x0000 .. 0xffff\n"
+      "    -oXXXX  org XXXX = 0x0000 .. 0xffff (0xfffff for the 8088)\n"
+      "    -sXXXX  start the output at XXXX\n"
+      "    -bXXXX  split a binary image into banks of XXXX bytes\n"
+      "    -wXXXX  switch the banks into the window at XXXX (default: above bank 0)\n"
       "    -p      parse program flow\n"
       "    -r      parse also rst and nmi\n"
-      "    -x      show hexdump\n",
+      "    -g      parse also the code guessed in what is left as data\n"
+      "    -eXXXX  parse also from the entry point XXXX\n"
+      "    -kFile  keep the analysis in the project File: load it, if it exists, parse only what is new, and save it back\n"
+      "    -mFile  name the routines found by the signatures in File, and parse them with -p\n"
+      "    -cFile  write the control flow and call graphs to File, as DOT, or as JSON for a .json File\n"
+      "    -cpu 8080|8085  decode the opcodes of the 8080 or 8085, in Intel mnemonics\n"
+      "    -cpu 8088  decode the opcodes of the 8086 or 8088, in its 1M address space, with only -f, -o, -s, -p, -r, -x and -j\n"
+      "    -t      bound the T-states of each routine, in notes and a report\n"
+      "    -i      bound the T-states with the interrupts disabled, from each DI\n"
+      "    -d      bound the stack depth of each entry point\n"
+      "    -a      show the text, fills and repeated words in the data as DEFM, FILL and DEFW\n"
+      "    -x      show hexdump\n"
+      "    -yFile  name the labels by the symbols in the CasZ80 snapshot File\n"
+      "    -vFile  match the routines with those of the older image File, and note those moved, changed, removed and added\n"
+      "    -jN     render the text with N threads (default: one for each processor)\n"
+      "    -       for the InFile: disassemble the standard input as it comes, in a linear sweep, with only -f, -o, -x, -j and -cpu 8080|8085\n",
       App
    );
 }
@@ -488,14 +2310,246 @@ static int GetHeader(FILE *InF, uint32_t &Address, uint32_t &Size) {
    return Status;
 }
 
+// Banked images.
+// ──────────────
+// A binary image may be split into banks, of BankSize bytes each, with -b; it may then be larger than the 64K address space.
+// The file is mapped into memory, rather than read, so that only the banks reached are ever loaded.
+// Bank 0 is fixed at the origin and each of the others is switched in turn into the window at BankWin, above it.
+// With the window at the origin, there is no fixed bank: each bank, bank 0 included, is seen in the window alone.
+// Each bank is parsed and written out in a view of its own; the views of the switched banks take the modes of the fixed bank over from its view,
+// so that it is only parsed once.
+static uint32_t BankSize = 0, BankWin = CodeMax;	// Options -b and -w; no banks, for BankSize = 0, and the default window, for BankWin = CodeMax.
+static const uint8_t *Image;	// The binary image, mapped from the file.
+static uint32_t ImageN, ImageAt;	// Its size and its origin.
+
+// Map Size bytes of InF, from At on, into memory; read them in, if the file cannot be mapped.
+static const uint8_t *MapFile(FILE *InF, uint32_t At, uint32_t Size) {
+#ifndef _WIN32
+   void *Map = mmap(nullptr, (size_t)At + Size, PROT_READ, MAP_PRIVATE, fileno(InF), 0);
+   if (Map != MAP_FAILED) return (const uint8_t *)Map + At;
+#endif
+   uint8_t *Buf = (uint8_t *)malloc(Size); if (Buf == nullptr) exit(1);
+   if (fseek(InF, At, SEEK_SET) != 0 || fread(Buf, 1, Size, InF) != Size) { free(Buf); return nullptr; }
+   return Buf;
+}
+
+// Load the symbols of a CasZ80 snapshot (see Lex.cpp): the file is mapped and the names are used in place.
+// Of the symbols at the same address, the first in alphabetical order is kept.
+static bool LoadSymbols(const char *File) {
+   static const char SnapSig[] = "CasSYM" "\032" "\n";
+   const size_t SnapHeadN = 8 + 4 + 4 + 8, SnapSymN = 4 + 4 + 2 + 2, NameMax = 0x40;
+   FILE *InF = fopen(File, "rb");
+   if (InF == nullptr) { fprintf(stderr, "Error: cannot open symbol snapshot \"%s\"\n", File); return false; }
+   fseek(InF, 0, SEEK_END); uint32_t SnapN = ftell(InF);
+   const uint8_t *Snap = SnapN >= SnapHeadN? MapFile(InF, 0, SnapN): nullptr;
+   fclose(InF);
+   auto GetL = [](const uint8_t *BP) { return (uint32_t)(BP[0] | BP[1] << 8 | BP[2] << 16 | (uint32_t)BP[3] << 24); };
+   uint32_t EntryN = 0, NameN = 0;
+   bool Ok = Snap != nullptr && memcmp(Snap, SnapSig, 8) == 0;
+   if (Ok) EntryN = GetL(Snap + 8), NameN = GetL(Snap + 12), Ok = SnapN == SnapHeadN + (size_t)EntryN*SnapSymN + NameN && NameN > 0;
+   if (!Ok) { fprintf(stderr, "Error: \"%s\" is not a symbol snapshot\n", File); return false; }
+   const uint8_t *BP = Snap + SnapHeadN;
+   const char *Names = (const char *)BP + EntryN*SnapSymN;
+   if (Names[NameN - 1] != '\0') { fprintf(stderr, "Error: \"%s\" is not a symbol snapshot\n", File); return false; }
+   for (uint32_t S = 0; S < EntryN; S++, BP += SnapSymN) {
+      uint32_t Name = GetL(BP), Value = GetL(BP + 4);
+      if (Name >= NameN || Value >= CodeMax || strlen(Names + Name) > NameMax) continue;
+      const char *&Sym = SymName[Value];
+      if (Sym == nullptr) SymN++, Sym = Names + Name;
+      else if (strcmp(Names + Name, Sym) < 0) Sym = Names + Name;
+   }
+   return true;
+}
+
+// Signatures.
+// ───────────
+// With -m, the routines of a library (multiply and divide, CRC, BDOS wrappers, ⋯) are found by their bytes, from a file of signatures, one to a line:
+//	Name	Bytes
+// with the bytes in hex, each pair optionally spaced out, ‟??” for a byte that may differ, such as that of a relocated address, and ‟;” starting a comment.
+// The whole image is searched for all of the signatures at once, in a single pass of an Aho-Corasick automaton over the longest run of fixed bytes in each,
+// and the rest of each signature is checked wherever its run is found.
+// A routine found is named by its signature, unless a symbol already names it, and, with -p, its address is parsed as an entry point.
+struct Signature {
+   const char *Name; uint8_t *Byte, *Mask;	// Its name, and its bytes and mask (0xff for a fixed byte, 0 for ‟??”).
+   uint32_t Len, Key, KeyLen;			// Its length and the offset and length of its longest run of fixed bytes.
+   int32_t Next;				// The next signature with the same run, or -1.
+};
+static Signature *Sigs; static uint32_t SigN, SigMax;
+
+// A state of the automaton: its children are linked through Next, the run of a signature ends at it (Out), and Link is the nearest state down its failure links at which one ends.
+// The root and the states just after it, where the search spends most of its time, have a row of all 256 transitions (Row), with the failures already taken.
+struct AcNode { int32_t Child, Next, Fail, Out, Link, Row; uint8_t Byte; };
+static AcNode *AcNodes; static uint32_t AcN, AcMax;
+static int32_t (*AcRows)[0x100];
+
+// A signature found at the image offset At.
+struct SigMatch { uint32_t At, Sig; };
+static SigMatch *SigMatches; static uint32_t SigMatchN;
+static uint16_t SigNamed[CodeMax]; static uint32_t SigNamedN;	// The addresses named by a signature, for the views seen so far.
+static uint16_t SigSeed[CodeMax]; static uint32_t SigSeedN;	// The addresses found in the current view, to be parsed.
+
+static int32_t AcChild(int32_t S, uint8_t Byte) {
+   for (int32_t C = AcNodes[S].Child; C >= 0; C = AcNodes[C].Next) if (AcNodes[C].Byte == Byte) return C;
+   return -1;
+}
+
+static int32_t AcNew(void) {
+   if (AcN >= AcMax) {
+      AcMax = AcMax == 0? 0x400: 2*AcMax;
+      AcNodes = (AcNode *)realloc(AcNodes, AcMax*sizeof *AcNodes); if (AcNodes == nullptr) exit(1);
+   }
+   AcNodes[AcN] = AcNode{ -1, -1, 0, -1, -1, -1, 0 };
+   return AcN++;
+}
+
+// The next state from S on Byte.
+static inline int32_t AcStep(int32_t S, uint8_t Byte) {
+   for (; AcNodes[S].Row < 0; S = AcNodes[S].Fail) { int32_t C = AcChild(S, Byte); if (C >= 0) return C; }
+   return AcRows[AcNodes[S].Row][Byte];
+}
+
+// Load the signatures of File and build their automaton.
+static bool LoadSignatures(const char *File) {
+   FILE *InF = fopen(File, "r");
+   if (InF == nullptr) { fprintf(stderr, "Error: cannot open signature file \"%s\"\n", File); return false; }
+   AcN = 0, AcNew();
+   char Buf[0x400];
+   for (unsigned Line = 1; fgets(Buf, sizeof Buf, InF) != nullptr; Line++) {
+      char *BP = Buf, *Name;
+      while (*BP == ' ' || *BP == '\t') BP++;
+      if (*BP == ';' || *BP == '\n' || *BP == '\r' || *BP == '\0') continue;
+      for (Name = BP; *BP != ' ' && *BP != '\t' && *BP != '\n' && *BP != '\r' && *BP != '\0'; BP++);
+      size_t NameN = BP - Name;
+      uint8_t Byte[0x200], Mask[0x200]; uint32_t Len = 0; bool Ok = NameN > 0;
+      while (Ok) {
+         while (*BP == ' ' || *BP == '\t') BP++;
+         if (*BP == ';' || *BP == '\n' || *BP == '\r' || *BP == '\0') break;
+         if (Len >= sizeof Byte) { Ok = false; break; }
+         if (BP[0] == '?' && BP[1] == '?') Byte[Len] = Mask[Len] = 0, Len++;
+         else if (isxdigit((unsigned char)BP[0]) && isxdigit((unsigned char)BP[1])) {
+            char Hex[3] = { BP[0], BP[1], '\0' };
+            Byte[Len] = strtoul(Hex, nullptr, 0x10), Mask[Len++] = 0xff;
+         } else Ok = false;
+         BP += 2;
+      }
+   // The longest run of fixed bytes.
+      uint32_t Key = 0, KeyLen = 0;
+      for (uint32_t B = 0, E; B < Len; B = E + 1) {
+         for (E = B; E < Len && Mask[E] != 0; E++);
+         if (E - B > KeyLen) Key = B, KeyLen = E - B;
+      }
+      if (!Ok || KeyLen == 0) { fprintf(stderr, "Error: bad signature in line %u of \"%s\"\n", Line, File); fclose(InF); return false; }
+      if (SigN >= SigMax) {
+         SigMax = SigMax == 0? 0x100: 2*SigMax;
+         Sigs = (Signature *)realloc(Sigs, SigMax*sizeof *Sigs); if (Sigs == nullptr) exit(1);
+      }
+      Signature &Sg = Sigs[SigN];
+      char *N = (char *)malloc(NameN + 1); Sg.Byte = (uint8_t *)malloc(Len), Sg.Mask = (uint8_t *)malloc(Len);
+      if (N == nullptr || Sg.Byte == nullptr || Sg.Mask == nullptr) exit(1);
+      memcpy(N, Name, NameN), N[NameN] = '\0', memcpy(Sg.Byte, Byte, Len), memcpy(Sg.Mask, Mask, Len);
+      Sg.Name = N, Sg.Len = Len, Sg.Key = Key, Sg.KeyLen = KeyLen;
+   // Its run, into the trie.
+      int32_t S = 0;
+      for (uint32_t K = Key; K < Key + KeyLen; K++) {
+         int32_t C = AcChild(S, Byte[K]);
+         if (C < 0) C = AcNew(), AcNodes[C].Byte = Byte[K], AcNodes[C].Next = AcNodes[S].Child, AcNodes[S].Child = C;
+         S = C;
+      }
+   // In the order of the file, so that the first of the signatures found at the same address is kept.
+      int32_t *Tail = &AcNodes[S].Out; while (*Tail >= 0) Tail = &Sigs[*Tail].Next;
+      *Tail = SigN, Sg.Next = -1, SigN++;
+   }
+   fclose(InF);
+// The failure links, breadth first, and the rows of the root and of its children.
+   int32_t *Queue = (int32_t *)malloc(AcN*sizeof *Queue); if (Queue == nullptr) exit(1);
+   uint32_t QHead = 0, QTail = 0, RowN = 1;
+   for (int32_t C = AcNodes[0].Child; C >= 0; C = AcNodes[C].Next) RowN++;
+   const uint32_t FirstN = RowN - 1; // The children of the root, first in the queue.
+   free(AcRows), AcRows = (int32_t (*)[0x100])malloc(RowN*sizeof *AcRows); if (AcRows == nullptr) exit(1);
+   AcNodes[0].Row = 0, RowN = 1;
+   for (int B = 0; B < 0x100; B++) AcRows[0][B] = 0;
+   for (int32_t C = AcNodes[0].Child; C >= 0; C = AcNodes[C].Next) AcRows[0][AcNodes[C].Byte] = C, AcNodes[C].Fail = 0, Queue[QTail++] = C;
+   while (QHead < QTail) {
+      int32_t S = Queue[QHead++];
+      for (int32_t C = AcNodes[S].Child; C >= 0; C = AcNodes[C].Next) {
+         int32_t F = AcStep(AcNodes[S].Fail, AcNodes[C].Byte);
+         AcNodes[C].Fail = F, AcNodes[C].Link = AcNodes[F].Out >= 0? F: AcNodes[F].Link, Queue[QTail++] = C;
+      }
+      if (QHead > FirstN) continue;
+   // A child of the root: its row, with the failures taken through the root.
+      int32_t *Row = AcRows[AcNodes[S].Row = RowN++];
+      for (int B = 0; B < 0x100; B++) Row[B] = AcRows[0][B];
+      for (int32_t C = AcNodes[S].Child; C >= 0; C = AcNodes[C].Next) Row[AcNodes[C].Byte] = C;
+   }
+   free(Queue);
+   return true;
+}
+
+static int CompareMatch(const void *A, const void *B) {
+   const SigMatch *MA = (const SigMatch *)A, *MB = (const SigMatch *)B;
+   return MA->At != MB->At? (MA->At < MB->At? -1: +1): MA->Sig != MB->Sig? (MA->Sig < MB->Sig? -1: +1): 0;
+}
+
+// Search the N bytes at Buf for the signatures, in one pass; keep the first signature found at each offset.
+static void MatchSignatures(const uint8_t *Buf, uint32_t N) {
+   uint32_t MatchMax = 0; SigMatchN = 0;
+   for (uint32_t I = 0, S = 0; I < N; I++) {
+      S = AcStep(S, Buf[I]);
+      for (int32_t T = AcNodes[S].Out >= 0? S: AcNodes[S].Link; T >= 0; T = AcNodes[T].Link) for (int32_t G = AcNodes[T].Out; G >= 0; G = Sigs[G].Next) {
+         const Signature &Sg = Sigs[G];
+         if (I + 1 < Sg.Key + Sg.KeyLen) continue;
+         uint32_t At = I + 1 - Sg.KeyLen - Sg.Key, K = 0;
+         if (At + Sg.Len > N) continue;
+         while (K < Sg.Len && (Buf[At + K]&Sg.Mask[K]) == Sg.Byte[K]) K++;
+         if (K < Sg.Len) continue;
+         if (SigMatchN >= MatchMax) {
+            MatchMax = MatchMax == 0? 0x100: 2*MatchMax;
+            SigMatches = (SigMatch *)realloc(SigMatches, MatchMax*sizeof *SigMatches); if (SigMatches == nullptr) exit(1);
+         }
+         SigMatches[SigMatchN++] = SigMatch{ At, uint32_t(G) };
+      }
+   }
+   qsort(SigMatches, SigMatchN, sizeof *SigMatches, CompareMatch);
+   uint32_t Kept = 0;
+   for (uint32_t M = 0; M < SigMatchN; M++) if (Kept == 0 || SigMatches[Kept - 1].At != SigMatches[M].At) SigMatches[Kept++] = SigMatches[M];
+   SigMatchN = Kept;
+   fprintf(stderr, "%u signature%s found\n", SigMatchN, SigMatchN == 1? "": "s");
+}
+
+// Name the routines found within the N bytes from the image offset Off, which are seen at the address At, in the current view.
+static void NameSignatures(uint32_t Off, uint32_t N, uint32_t At) {
+   SigSeedN = 0;
+   for (uint32_t M = 0; M < SigMatchN; M++) {
+      const SigMatch &Mt = SigMatches[M];
+      if (Mt.At < Off || Mt.At + Sigs[Mt.Sig].Len > Off + N) continue;
+      uint16_t IP = At + (Mt.At - Off);
+      SigSeed[SigSeedN++] = IP;
+      if (SymName[IP] == nullptr) SymName[IP] = Sigs[Mt.Sig].Name, SymN++, SigNamed[SigNamedN++] = IP;
+   }
+}
+
+// Drop the names given by signatures, but for the first Keep of them.
+static void DropSignatures(uint32_t Keep) {
+   while (SigNamedN > Keep) SymName[SigNamed[--SigNamedN]] = nullptr, SymN--;
+}
+
+static bool HexOut = false;	// A HEX record fell outside of the address space.
+
 static bool LoadBin(char *InFile, uint32_t Offset) {
    bool Ok = false;
    FILE *InF = fopen(InFile, "rb"); if (InF == nullptr) return Ok;
    uint32_t Size;
    if (strlen(InFile) > 4 && strcmp(InFile + strlen(InFile) - 4, ".hex") == 0) {
-      struct HexIn Q;
-      char Buf[0x100];
-      while (fgets(Buf, sizeof Buf, InF)) Q.Get(Buf, strlen(Buf));
+      if (BankSize > 0) {
+         fprintf(stderr, "Error: option -b needs a binary image\n");
+         goto End1;
+      }
+      {
+         struct HexIn Q;
+         char Buf[0x100];
+         while (fgets(Buf, sizeof Buf, InF)) Q.Get(Buf, strlen(Buf));
+      }
+      if (HexOut) goto End1;
       goto End2;
    } else if (strlen(InFile) > 4 && strcmp(InFile + strlen(InFile) - 4, ".z80") == 0) {
       int Status = GetHeader(InF, Offset, Size);
@@ -504,13 +2558,15 @@ static bool LoadBin(char *InFile, uint32_t Offset) {
          goto End1;
       }
    } else fseek(InF, 0, SEEK_END), Size = ftell(InF), fseek(InF, 0, SEEK_SET); // bin file.
-   if (Size < 1 || Size > CodeMax - Offset) {
-      fprintf(stderr, "File size (%u bytes) exceeds available RAM size (%u bytes)\n", Size, CodeMax - Offset);
+   if (Size < 1 || BankSize == 0 && Size > SpaceN - Offset) {
+      fprintf(stderr, "File size (%u bytes) exceeds available RAM size (%u bytes)\n", Size, SpaceN - Offset);
       goto End1;
-   } else if (Size != (unsigned)fread(Code + Offset, 1, (size_t)Size, InF)) {
+   } else if ((Image = MapFile(InF, ftell(InF), Size)) == nullptr) {
       fprintf(stderr, "Cannot read file: \"%s\"\n", InFile);
       goto End1;
    }
+   ImageN = Size, ImageAt = Offset;
+   if (BankSize == 0) memcpy(Code + Offset, Image, Size);
    LoRAM = Offset, HiRAM = Offset + Size - 1;
 End2:
    Ok = true;
@@ -519,16 +2575,707 @@ End1:
    return Ok;
 }
 
+// Projects.
+// ─────────
+// With -kFile, the analysis of the image is kept in the project File, a text file that is read in, if it exists, and written back once the image is parsed.
+// It holds the parts entered by hand, one to a line, which are kept as they are:
+//	entry XXXX		an entry point, parsed as code, as are those added with -eXXXX,
+//	data XXXX YYYY		the addresses XXXX to YYYY, left as data, even where they are reached as code,
+//	label XXXX Name		the name of XXXX, as if from a symbol snapshot,
+//	note XXXX Text		a comment on the line at XXXX,
+// and the state of the parse, which is written anew each time:
+//	image Lo Hi Hash Cpu	the image that it was parsed from,
+//	mode ⋯			Mode[] over the whole address space, in runs, with each run of opcodes, and their operands, taken as one,
+//	refs ⋯			the addresses referred to as code, marked 0x10 in Mode[],
+//	table XXXX YYYY		a target of an indirect jump, resolved through a table.
+// For the same image, Mode[] is taken as it was left and not parsed again: only the entry points not yet parsed, such as those just added,
+// are followed, into the code that they reach which is not already known.
+static uint16_t *Entries; static uint32_t EntryN, EntryMax;	// The entry points of the project and of -e.
+struct DataRange { uint16_t Lo, Hi; };
+static DataRange *DataRanges; static uint32_t DataRangeN, DataRangeMax;
+struct ProjLine { uint16_t At; const char *Text; };	// A label or note.
+static ProjLine *ProjLabels, *ProjNotes; static uint32_t ProjLabelN, ProjLabelMax, ProjNoteN, ProjNoteMax;
+
+// Make room for one more item in an array of Max items of the given size.
+static void *GrowArray(void *Array, uint32_t &Max, size_t Size) {
+   Max = Max == 0? 0x10: 2*Max;
+   Array = realloc(Array, Max*Size); if (Array == nullptr) exit(1);
+   return Array;
+}
+
+static void AddEntry(uint16_t IP) {
+   for (uint32_t E = 0; E < EntryN; E++) if (Entries[E] == IP) return;
+   if (EntryN >= EntryMax) Entries = (uint16_t *)GrowArray(Entries, EntryMax, sizeof *Entries);
+   Entries[EntryN++] = IP;
+}
+
+static void AddProjLine(ProjLine *&Lines, uint32_t &N, uint32_t &Max, uint16_t At, const char *Text) {
+   if (N >= Max) Lines = (ProjLine *)GrowArray(Lines, Max, sizeof *Lines);
+   char *T = (char *)malloc(strlen(Text) + 1); if (T == nullptr) exit(1);
+   Lines[N].At = At, Lines[N++].Text = strcpy(T, Text);
+}
+
+// The hash of the image of the current view, with its bounds and the processor.
+static uint64_t ImageHash(void) {
+   uint64_t H = Mix(Mix(Mix(0xcbf29ce484222325ULL, LoRAM), HiRAM), BasePg);
+   for (uint32_t IP = LoRAM; IP <= HiRAM; IP++) H = Mix(H, Code[IP]);
+   return H;
+}
+
+// Set the modes of the runs of Line, from IP on; return false, if it is not well-formed.
+static bool GetModes(const char *Line, uint32_t &IP) {
+   for (const char *BP = Line; ; ) {
+      while (*BP == ' ' || *BP == '\t') BP++;
+      if (*BP == '\n' || *BP == '\r' || *BP == '\0') return true;
+      char Kind = *BP++, *EndP; uint32_t N = strtoul(BP, &EndP, 0x10);
+      if (EndP == BP || N == 0) return false;
+      BP = EndP;
+      switch (Kind) {
+      // A run of opcodes, each with its operands, and one of words, each with the operand after it.
+         case 'C':
+            while (N-- > 0) {
+               if (IP >= CodeMax) return false;
+               int Len = Decode(IP); if (IP + Len > CodeMax) return false;
+               Mode[IP++] = Opcode; while (--Len > 0) Mode[IP++] = Operand;
+            }
+         break;
+         case 'W': if (IP + 2*N > CodeMax) return false; while (N-- > 0) Mode[IP++] = Word, Mode[IP++] = Operand; break;
+      // A run of bytes of one mode.
+         default: {
+            const char *K = strchr("EOPDX", Kind); if (Kind == '\0' || K == nullptr || IP + N > CodeMax) return false;
+            memset(Mode + IP, K - "EOPDX", N), IP += N;
+         }
+         break;
+      }
+   }
+}
+
+// Load the project File, if it exists; set Kept, if Mode[] is taken from it.
+static bool LoadProject(const char *File, bool &Kept) {
+   Kept = false;
+   FILE *InF = fopen(File, "r"); if (InF == nullptr) return true;
+   enum { NoImage, SameImage, NewImage } Image = NoImage;
+   uint32_t ModeAt = 0;
+   char Buf[0x400];
+   for (unsigned Line = 1; fgets(Buf, sizeof Buf, InF) != nullptr; Line++) {
+      char *BP = Buf, *EndP = Buf + strlen(Buf);
+      while (EndP > Buf && (EndP[-1] == '\n' || EndP[-1] == '\r')) *--EndP = '\0';
+      while (*BP == ' ' || *BP == '\t') BP++;
+      if (*BP == ';' || *BP == '\0') continue;
+      char Key[0x10], Name[0x41]; unsigned A, B; unsigned long long H; int N = 0; bool Ok = true;
+      if (sscanf(BP, "%15s%n", Key, &N) != 1) Ok = false;
+      else if (BP += N, strcmp(Key, "entry") == 0) {
+         Ok = sscanf(BP, "%x", &A) == 1 && A < CodeMax;
+         if (Ok) AddEntry(A);
+      }
+      else if (strcmp(Key, "data") == 0) {
+         Ok = sscanf(BP, "%x %x", &A, &B) == 2 && A <= B && B < CodeMax;
+         if (Ok) {
+            if (DataRangeN >= DataRangeMax) DataRanges = (DataRange *)GrowArray(DataRanges, DataRangeMax, sizeof *DataRanges);
+            DataRanges[DataRangeN].Lo = A, DataRanges[DataRangeN++].Hi = B;
+         }
+      } else if (strcmp(Key, "label") == 0) {
+         Ok = sscanf(BP, "%x %64s", &A, Name) == 2 && A < CodeMax;
+         if (Ok) {
+            AddProjLine(ProjLabels, ProjLabelN, ProjLabelMax, A, Name);
+            if (SymName[A] == nullptr) SymN++;
+            SymName[A] = ProjLabels[ProjLabelN - 1].Text;
+         }
+      } else if (strcmp(Key, "note") == 0) {
+         Ok = sscanf(BP, "%x %n", &A, &N) == 1 && A < CodeMax;
+         if (Ok) AddProjLine(ProjNotes, ProjNoteN, ProjNoteMax, A, BP + N);
+      } else if (strcmp(Key, "image") == 0) {
+         Ok = sscanf(BP, "%x %x %llx %x", &A, &B, &H, &N) == 4;
+         Image = Ok && A == LoRAM && B == HiRAM && (unsigned)N == BasePg && H == ImageHash()? SameImage: NewImage;
+         if (Image == NewImage) fprintf(stderr, "Warning: the image is not the one that the project \"%s\" was saved for: it is parsed again\n", File);
+      } else if (Image != SameImage) Ok = strcmp(Key, "mode") == 0 || strcmp(Key, "refs") == 0 || strcmp(Key, "table") == 0;
+      else if (strcmp(Key, "mode") == 0) Ok = GetModes(BP, ModeAt);
+      else if (strcmp(Key, "refs") == 0) {
+         for (char *RP = BP; Ok && sscanf(RP, "%x%n", &A, &N) == 1; RP += N) if ((Ok = A < CodeMax)) Mode[A] |= 0x10;
+      } else if (strcmp(Key, "table") == 0) {
+         Ok = sscanf(BP, "%x %x", &A, &B) == 2 && A < CodeMax && B < CodeMax;
+         if (Ok) {
+            if (TabEdgeN >= TabEdgeMax) TabEdges = (TabEdge *)GrowArray(TabEdges, TabEdgeMax, sizeof *TabEdges);
+            TabEdges[TabEdgeN].From = A, TabEdges[TabEdgeN++].To = B;
+         }
+      } else Ok = false;
+      if (!Ok) { fprintf(stderr, "Error: bad line %u in the project \"%s\"\n", Line, File); fclose(InF); return false; }
+   }
+   fclose(InF);
+   if (Image == SameImage && ModeAt != CodeMax) { fprintf(stderr, "Error: the modes in the project \"%s\" are cut short\n", File); return false; }
+   Kept = Image == SameImage;
+   return true;
+}
+
+// Leave the data ranges of the project as data.
+static void KeepData(void) {
+   for (uint32_t R = 0; R < DataRangeN; R++)
+      for (uint32_t IP = DataRanges[R].Lo; IP <= DataRanges[R].Hi; IP++) Mode[IP] = Data | (Mode[IP]&0x10);
+}
+
+// Put the notes of the project on their lines.
+static void ProjectNotes(void) { for (uint32_t N = 0; N < ProjNoteN; N++) AddNote(ProjNotes[N].At, "%s", ProjNotes[N].Text); }
+
+// Write the project, with the analysis of the current view, to File: to a temporary file first, which then replaces it.
+static bool SaveProject(const char *File) {
+   char TmpFile[0x400]; snprintf(TmpFile, sizeof TmpFile, "%s.tmp", File);
+   FILE *ExF = fopen(TmpFile, "w");
+   if (ExF == nullptr) { fprintf(stderr, "Error: cannot write the project \"%s\"\n", File); return false; }
+   fprintf(ExF, "; DasZ80 project.\n; Entered by hand: entry XXXX, data XXXX YYYY, label XXXX Name, note XXXX Text.\n");
+   for (uint32_t E = 0; E < EntryN; E++) fprintf(ExF, "entry %04X\n", Entries[E]);
+   for (uint32_t R = 0; R < DataRangeN; R++) fprintf(ExF, "data %04X %04X\n", DataRanges[R].Lo, DataRanges[R].Hi);
+   for (uint32_t L = 0; L < ProjLabelN; L++) fprintf(ExF, "label %04X %s\n", ProjLabels[L].At, ProjLabels[L].Text);
+   for (uint32_t N = 0; N < ProjNoteN; N++) fprintf(ExF, "note %04X %s\n", ProjNotes[N].At, ProjNotes[N].Text);
+   fprintf(ExF, "; The parse, written anew by each run.\nimage %04X %04X %016llX %X\n", LoRAM, HiRAM, (unsigned long long)ImageHash(), BasePg);
+// The modes, 16 runs to a line.
+   unsigned RunN = 0;
+   for (uint32_t IP = 0; IP < CodeMax; ) {
+      uint8_t M = Mode[IP]&0x0f; uint32_t Lo = IP, N = 0; char Kind = "EOPDX"[M];
+      if (M == Opcode) {
+         for (int Len; IP < CodeMax && (Mode[IP]&0x0f) == Opcode && IP + (Len = Decode(IP)) <= CodeMax; IP += Len, N++) {
+            int n = 1; while (n < Len && (Mode[IP + n]&0x0f) == Operand) n++;
+            if (n < Len) break;
+         }
+         if (N > 0) Kind = 'C'; else IP++, N = 1;
+      } else if (M == Word) {
+         for (; IP + 1 < CodeMax && (Mode[IP]&0x0f) == Word && (Mode[IP + 1]&0x0f) == Operand; IP += 2) N++;
+         if (N > 0) Kind = 'W'; else IP++, N = 1;
+      } else {
+         while (IP < CodeMax && (Mode[IP]&0x0f) == M) IP++;
+         N = IP - Lo;
+      }
+      fprintf(ExF, RunN == 0? "mode %c%X": " %c%X", Kind, N);
+      if (++RunN == 0x10) fputc('\n', ExF), RunN = 0;
+   }
+   if (RunN > 0) fputc('\n', ExF);
+// The references, 16 to a line.
+   RunN = 0;
+   for (uint32_t IP = 0; IP < CodeMax; IP++) if (Mode[IP]&0x10) {
+      fprintf(ExF, RunN == 0? "refs %04X": " %04X", IP);
+      if (++RunN == 0x10) fputc('\n', ExF), RunN = 0;
+   }
+   if (RunN > 0) fputc('\n', ExF);
+   for (uint32_t T = 0; T < TabEdgeN; T++) fprintf(ExF, "table %04X %04X\n", TabEdges[T].From, TabEdges[T].To);
+   if (fclose(ExF) != 0) { remove(TmpFile); fprintf(stderr, "Error: cannot write the project \"%s\"\n", File); return false; }
+   remove(File), rename(TmpFile, File);
+   return true;
+}
+
+// Parse the program flow of the current view, from Lo to the end of the image, with Lo as the entry, and, with Added, the entry points of -e and the project.
+// Unless Fresh, the modes already set, as those kept in a project, are taken as they are, and only the code not yet known is followed.
+static void ParseFlow(uint32_t Lo, bool DoParseInt, bool DoGuess, bool Fresh = true, bool Added = false) {
+   if (Fresh) {
+      TabEdgeN = 0;
+   // All data, by starting default.
+      for (uint32_t IP = Lo; IP <= HiRAM; IP++) Mode[IP] = Data;
+   }
+   if (DoParseInt) {
+   // Parse the rst vectors, if needed.
+      for (int IP = 0; IP < 0100; IP += 010) if ((Mode[IP]&0x0f) == Data) OpScan(IP, ByVector);
+   // Also, parse the NMI vector, if needed.
+      if ((Mode[0146]&0x0f) == Data) OpScan(0146, ByVector);
+   }
+   OpScan(Lo, ByStart);
+// The routines found by their signatures.
+   for (uint32_t S = 0; S < SigSeedN; S++) if ((Mode[SigSeed[S]]&0x0f) == Data) OpScan(SigSeed[S], BySig);
+   if (Added) for (uint32_t E = 0; E < EntryN; E++) OpScan(Entries[E], ByStart);
+   if (DoGuess) GuessCode();
+}
+
+// Streams.
+// ────────
+// With ‟-” for the input file, the image is read from the standard input as it comes, such as from a pipe, which can be neither seeked nor mapped.
+// It is disassembled in a linear sweep, without parsing, a block at a time, and the lines of each block are written out before the next one is read,
+// so only the memory of one view is used, however long the stream is.
+// The code of the view is used as a ring, at the addresses from the origin on, wrapping past FFFF, where a new ‟ORG” is put.
+// The lines of a block are only taken up to the last LookMax bytes read, so that no opcode is decoded before all of its bytes are in;
+// after the last block, the rest are taken, with the fill bytes after them, as at the end of an image.
+static const uint32_t StreamBlock = 0x1000;	// The size of the blocks read.
+static const uint32_t LookMax = 4;		// The length of the longest opcode.
+
+// Read up to N bytes of what has come of the stream Fd into Buf; return 0 at its end, or -1 on an error.
+static long ReadSome(int Fd, uint8_t *Buf, uint32_t N) {
+#ifndef _WIN32
+   return read(Fd, Buf, N);
+#else
+   return _read(Fd, Buf, N);
+#endif
+}
+
+// Disassemble the stream Fd, from the origin At, to ExF.
+static int DasStream(int Fd, FILE *ExF, uint16_t At, int Fill) {
+   View *V = NewView(Fill);
+   LoRAM = 0, HiRAM = CodeMax - 1;
+   uint16_t IP = At; uint32_t Ready = 0;	// The start of the next line, and the number of bytes read from it on.
+   Chunk C{ 0, 0, OutBuf{ nullptr, 0, 0 } };
+   bool Wrap = false;	// The addresses have wrapped past FFFF since the last line.
+   fprintf(ExF, "        ORG     $%04X\n", IP);
+   for (bool End = false; !End; ) {
+   // The next block, or as much of it as has come, into the ring, up to where it wraps.
+      uint16_t To = IP + Ready; uint32_t Want = StreamBlock < CodeMax - To? StreamBlock: CodeMax - To;
+      long N = ReadSome(Fd, Code + To, Want);
+      if (N < 0) {
+         fprintf(stderr, "Error: cannot read the standard input\n");
+         free(C.Text.Buf), free(V);
+         return 1;
+      }
+      memset(DcLen + To, 0, N), Ready += N, End = N == 0;
+      if (End) for (uint32_t n = 0; n < LookMax - 1; n++) {
+         uint16_t After = IP + Ready + n; Code[After] = Fill, DcLen[After] = 0;
+      }
+   // The lines, in chunks up to where the addresses wrap.
+      while (Ready >= LookMax || End && Ready > 0) {
+         uint32_t Used = 0;
+         C.Lo = C.Hi = IP;
+         while ((Used + LookMax <= Ready || End && Used < Ready) && C.Hi < CodeMax) {
+            uint32_t Len = Decode(C.Hi); C.Hi += Len, Used += Len;
+         }
+         if (Wrap) fprintf(ExF, "        ORG     $%04X\n", IP), Wrap = false;
+         C.Text.N = 0, Render(C), fwrite(C.Text.Buf, 1, C.Text.N, ExF);
+         Ready = Used < Ready? Ready - Used: 0, IP = uint16_t(C.Hi), Wrap = C.Hi >= CodeMax;
+      }
+      fflush(ExF);
+   }
+   free(C.Text.Buf), free(V);
+   return 0;
+}
+
+// The 8086 and 8088.
+// ──────────────────
+// With ‟-cpu 8088” (or 8086), the image is the code of an 8086 or 8088 in real mode, in the 1M address space of its 20-bit linear addresses.
+// A binary image is loaded at the origin set with -o; a HEX file is placed by its segment records (HexSegRec), at 16 times the segment plus the address,
+// and its start record (HexStartSegRec), if it has one, gives the entry point.
+// Each opcode is decoded from a table of 256 entries, laid out as in 8088Op.htm and built at compile time, each entry giving
+// the operand format (and so the length), the flow kind, the template for the text and the group, whose mnemonic comes from the reg field of the ModR/M byte.
+// The prefixes, the segment overrides, ‟LOCK”, ‟REP” and ‟REPNE”, are decoded as a part of the opcode that they come before.
+// With -p, the program flow is followed as in OpScan(), from the entry (by default, the reset address FFFF0, if it is in the image, else the start of the image),
+// with the code segment CS of each path: a near jump or call stays in CS, a far one sets it.
+// With -r, the vectors of the interrupt table at 0, if the image holds it, are followed too.
+// The lines are written out as those of the Z80 are, with the addresses as 5 hex digits.
+// In the templates of the table, after the notation of 8088Op.htm:
+//	%e, %E	Eb or Ew: the register or memory operand of the ModR/M byte, with its size, ‟BYTE” or ‟WORD”, in a group,
+//	%g, %G	Rb or Rw: the register of the reg field,
+//	%S	Rs: the segment register of the reg field,
+//	%q, %r	the byte or word register of the opcode's low 3 bits,
+//	%b, %w, %s	Ib, Iw or Is: the immediate byte, word or signed byte,
+//	%i	the immediate byte or word of ‟TEST” in group 6, if any,
+//	%j, %a	Js or Jw, and Af: the near target of a jump and a far address,
+//	%m	[Aw]: a direct memory operand,
+//	%x	the mnemonic of the group, padded to the operand column,
+//	%o	the opcode of an ‟ESC”, from its low 3 bits and the reg field.
+static const uint32_t Space86 = 0x100000;
+static bool Cpu86 = false;	// -cpu 8086 or 8088.
+static uint16_t *Seg86;		// The code segment of each opcode, as the flow reached it.
+static uint32_t HexEntry = ~0U; static uint16_t HexEntryCS;	// The start of a HEX file, from its HexStartSegRec.
+
+// The operand formats.
+enum Form86 {
+   XNone,	// No operand.
+   XB, XW,	// An immediate byte or word.
+   XJs, XJw,	// A near jump target, relative by a signed byte or a word.
+   XAf,		// A far address: the offset, then the segment.
+   XAw,		// A direct memory address.
+   XR,		// A ModR/M byte, with its displacement.
+   XRB, XRW,	// A ModR/M byte, then an immediate byte or word.
+   XPre,	// A prefix.
+   XBad		// Not an opcode of the processor: it is left as data.
+};
+
+// The groups, after 8088Op.htm: those with a ModR/M byte whose reg field selects the operation.
+enum Group86 { GpNone, Gp1, Gp3, Gp4, Gp5, Gp6, Gp7, GpN };
+static const char *const GpName[GpN][8] = {
+   { },
+   { "ADD", "OR", "ADC", "SBB", "AND", "SUB", "XOR", "CMP" },
+   { "POP" },
+// Undocumented: all the reg fields of "mov Eb,Ib" and "mov Ew,Iw", and 6 for "shl".
+   { "MOV", "MOV", "MOV", "MOV", "MOV", "MOV", "MOV", "MOV" },
+   { "ROL", "ROR", "RCL", "RCR", "SHL", "SHR", "SHL", "SAR" },
+   { "TEST", "TEST", "NOT", "NEG", "MUL", "IMUL", "DIV", "IDIV" },
+   { "INC", "DEC", "CALL", "CALL    FAR ", "JMP", "JMP     FAR ", "PUSH" }
+};
+
+struct Op86 {
+   const char *Text;	// The template for the text.
+   uint8_t Form = XNone;	// The operand format (Form86).
+   uint8_t Flow = FlNone;	// The flow kind (FlowT).
+   uint8_t Group = GpNone;	// The group (Group86).
+};
+
+// Undocumented: "pop CS" (0017), "salc" (0326) and group 1 at 0202.
+static constexpr Op86 Ops86[0x100] = {
+// 00z
+   { "ADD     %e,%g", XR }, { "ADD     %E,%G", XR }, { "ADD     %g,%e", XR }, { "ADD     %G,%E", XR },
+   { "ADD     AL,%b", XB }, { "ADD     AX,%w", XW }, { "PUSH    ES" }, { "POP     ES" },
+// 01z
+   { "OR      %e,%g", XR }, { "OR      %E,%G", XR }, { "OR      %g,%e", XR }, { "OR      %G,%E", XR },
+   { "OR      AL,%b", XB }, { "OR      AX,%w", XW }, { "PUSH    CS" }, { "POP     CS", XNone, FlJumpInd },
+// 02z
+   { "ADC     %e,%g", XR }, { "ADC     %E,%G", XR }, { "ADC     %g,%e", XR }, { "ADC     %G,%E", XR },
+   { "ADC     AL,%b", XB }, { "ADC     AX,%w", XW }, { "PUSH    SS" }, { "POP     SS" },
+// 03z
+   { "SBB     %e,%g", XR }, { "SBB     %E,%G", XR }, { "SBB     %g,%e", XR }, { "SBB     %G,%E", XR },
+   { "SBB     AL,%b", XB }, { "SBB     AX,%w", XW }, { "PUSH    DS" }, { "POP     DS" },
+// 04z
+   { "AND     %e,%g", XR }, { "AND     %E,%G", XR }, { "AND     %g,%e", XR }, { "AND     %G,%E", XR },
+   { "AND     AL,%b", XB }, { "AND     AX,%w", XW }, { "ES:", XPre }, { "DAA" },
+// 05z
+   { "SUB     %e,%g", XR }, { "SUB     %E,%G", XR }, { "SUB     %g,%e", XR }, { "SUB     %G,%E", XR },
+   { "SUB     AL,%b", XB }, { "SUB     AX,%w", XW }, { "CS:", XPre }, { "DAS" },
+// 06z
+   { "XOR     %e,%g", XR }, { "XOR     %E,%G", XR }, { "XOR     %g,%e", XR }, { "XOR     %G,%E", XR },
+   { "XOR     AL,%b", XB }, { "XOR     AX,%w", XW }, { "SS:", XPre }, { "AAA" },
+// 07z
+   { "CMP     %e,%g", XR }, { "CMP     %E,%G", XR }, { "CMP     %g,%e", XR }, { "CMP     %G,%E", XR },
+   { "CMP     AL,%b", XB }, { "CMP     AX,%w", XW }, { "DS:", XPre }, { "AAS" },
+// 10z
+   { "INC     %r" }, { "INC     %r" }, { "INC     %r" }, { "INC     %r" }, { "INC     %r" }, { "INC     %r" }, { "INC     %r" }, { "INC     %r" },
+// 11z
+   { "DEC     %r" }, { "DEC     %r" }, { "DEC     %r" }, { "DEC     %r" }, { "DEC     %r" }, { "DEC     %r" }, { "DEC     %r" }, { "DEC     %r" },
+// 12z
+   { "PUSH    %r" }, { "PUSH    %r" }, { "PUSH    %r" }, { "PUSH    %r" }, { "PUSH    %r" }, { "PUSH    %r" }, { "PUSH    %r" }, { "PUSH    %r" },
+// 13z
+   { "POP     %r" }, { "POP     %r" }, { "POP     %r" }, { "POP     %r" }, { "POP     %r" }, { "POP     %r" }, { "POP     %r" }, { "POP     %r" },
+// 14z
+   { nullptr, XBad }, { nullptr, XBad }, { nullptr, XBad }, { nullptr, XBad }, { nullptr, XBad }, { nullptr, XBad }, { nullptr, XBad }, { nullptr, XBad },
+// 15z
+   { nullptr, XBad }, { nullptr, XBad }, { nullptr, XBad }, { nullptr, XBad }, { nullptr, XBad }, { nullptr, XBad }, { nullptr, XBad }, { nullptr, XBad },
+// 16z
+   { "JO      %j", XJs, FlBranch }, { "JNO     %j", XJs, FlBranch }, { "JB      %j", XJs, FlBranch }, { "JNB     %j", XJs, FlBranch },
+   { "JE      %j", XJs, FlBranch }, { "JNE     %j", XJs, FlBranch }, { "JBE     %j", XJs, FlBranch }, { "JNBE    %j", XJs, FlBranch },
+// 17z
+   { "JS      %j", XJs, FlBranch }, { "JNS     %j", XJs, FlBranch }, { "JP      %j", XJs, FlBranch }, { "JNP     %j", XJs, FlBranch },
+   { "JL      %j", XJs, FlBranch }, { "JNL     %j", XJs, FlBranch }, { "JLE     %j", XJs, FlBranch }, { "JNLE    %j", XJs, FlBranch },
+// 20z
+   { "%x%e,%b", XRB, FlNone, Gp1 }, { "%x%E,%w", XRW, FlNone, Gp1 }, { "%x%e,%b", XRB, FlNone, Gp1 }, { "%x%E,%s", XRB, FlNone, Gp1 },
+   { "TEST    %e,%g", XR }, { "TEST    %E,%G", XR }, { "XCHG    %g,%e", XR }, { "XCHG    %G,%E", XR },
+// 21z
+   { "MOV     %e,%g", XR }, { "MOV     %E,%G", XR }, { "MOV     %g,%e", XR }, { "MOV     %G,%E", XR },
+   { "MOV     %E,%S", XR }, { "LEA     %G,%E", XR }, { "MOV     %S,%E", XR }, { "%x%E", XR, FlNone, Gp3 },
+// 22z
+   { "NOP" }, { "XCHG    AX,%r" }, { "XCHG    AX,%r" }, { "XCHG    AX,%r" }, { "XCHG    AX,%r" }, { "XCHG    AX,%r" }, { "XCHG    AX,%r" }, { "XCHG    AX,%r" },
+// 23z
+   { "CBW" }, { "CWD" }, { "CALL    %a", XAf, FlCall }, { "WAIT" }, { "PUSHF" }, { "POPF" }, { "SAHF" }, { "LAHF" },
+// 24z
+   { "MOV     AL,%m", XAw }, { "MOV     AX,%m", XAw }, { "MOV     %m,AL", XAw }, { "MOV     %m,AX", XAw },
+   { "MOVSB" }, { "MOVSW" }, { "CMPSB" }, { "CMPSW" },
+// 25z
+   { "TEST    AL,%b", XB }, { "TEST    AX,%w", XW }, { "STOSB" }, { "STOSW" }, { "LODSB" }, { "LODSW" }, { "SCASB" }, { "SCASW" },
+// 26z
+   { "MOV     %q,%b", XB }, { "MOV     %q,%b", XB }, { "MOV     %q,%b", XB }, { "MOV     %q,%b", XB },
+   { "MOV     %q,%b", XB }, { "MOV     %q,%b", XB }, { "MOV     %q,%b", XB }, { "MOV     %q,%b", XB },
+// 27z
+   { "MOV     %r,%w", XW }, { "MOV     %r,%w", XW }, { "MOV     %r,%w", XW }, { "MOV     %r,%w", XW },
+   { "MOV     %r,%w", XW }, { "MOV     %r,%w", XW }, { "MOV     %r,%w", XW }, { "MOV     %r,%w", XW },
+// 30z
+   { nullptr, XBad }, { nullptr, XBad }, { "RET     %w", XW, FlRet }, { "RET", XNone, FlRet },
+   { "LES     %G,%E", XR }, { "LDS     %G,%E", XR }, { "%x%e,%b", XRB, FlNone, Gp4 }, { "%x%E,%w", XRW, FlNone, Gp4 },
+// 31z
+   { nullptr, XBad }, { nullptr, XBad }, { "RETF    %w", XW, FlRet }, { "RETF", XNone, FlRet },
+   { "INT     3" }, { "INT     %b", XB }, { "INTO" }, { "IRET", XNone, FlRet },
+// 32z
+   { "%x%e,1", XR, FlNone, Gp5 }, { "%x%E,1", XR, FlNone, Gp5 }, { "%x%e,CL", XR, FlNone, Gp5 }, { "%x%E,CL", XR, FlNone, Gp5 },
+   { "AAM     %b", XB }, { "AAD     %b", XB }, { "SALC" }, { "XLAT" },
+// 33z
+   { "ESC     %o,%E", XR }, { "ESC     %o,%E", XR }, { "ESC     %o,%E", XR }, { "ESC     %o,%E", XR },
+   { "ESC     %o,%E", XR }, { "ESC     %o,%E", XR }, { "ESC     %o,%E", XR }, { "ESC     %o,%E", XR },
+// 34z
+   { "LOOPNZ  %j", XJs, FlBranch }, { "LOOPZ   %j", XJs, FlBranch }, { "LOOP    %j", XJs, FlBranch }, { "JCXZ    %j", XJs, FlBranch },
+   { "IN      AL,%b", XB }, { "IN      AX,%b", XB }, { "OUT     %b,AL", XB }, { "OUT     %b,AX", XB },
+// 35z
+   { "CALL    %j", XJw, FlCall }, { "JMP     %j", XJw, FlJump }, { "JMP     %a", XAf, FlJump }, { "JMP     %j", XJs, FlJump },
+   { "IN      AL,DX" }, { "IN      AX,DX" }, { "OUT     DX,AL" }, { "OUT     DX,AX" },
+// 36z
+   { "LOCK", XPre }, { nullptr, XBad }, { "REPNE", XPre }, { "REP", XPre },
+   { "HLT" }, { "CMC" }, { "%x%e%i", XR, FlNone, Gp6 }, { "%x%E%i", XR, FlNone, Gp6 },
+// 37z
+   { "CLC" }, { "STC" }, { "CLI" }, { "STI" }, { "CLD" }, { "STD" }, { "%x%e", XR, FlNone, Gp7 }, { "%x%E", XR, FlNone, Gp7 }
+};
+
+// An opcode, decoded.
+struct Dc86 {
+   const Op86 *Info;	// Its table entry.
+   const char *Name;	// The mnemonic of its group, or nullptr.
+   uint32_t Target;	// The target of a jump or call, as a linear address.
+   uint16_t Imm, Far;	// The immediate operand, direct address or offset, and the segment of a far address.
+   int16_t Disp;	// The displacement of the memory operand.
+   uint8_t Len, Op, Flow, ImmN;	// The length, with the prefixes; the opcode byte; the flow kind; the number of immediate bytes.
+   uint8_t Mod, Reg, Rm;	// The fields of the ModR/M byte.
+   uint8_t Seg, Rep, Lock;	// The prefixes: the segment override (or NoSeg), ‟REP” (0363) or ‟REPNE” (0362), or 0, and ‟LOCK”.
+};
+static const uint8_t NoSeg = 0xff;
+
+static inline uint8_t Get86(uint32_t A) { return Code[A&(Space86 - 1)]; }
+static inline uint32_t Linear(uint16_t Seg, uint16_t Off) { return (((uint32_t)Seg << 4) + Off)&(Space86 - 1); }
+
+// Decode the opcode at IP, in the code segment CS, into D; return whether it is an opcode of the processor.
+static bool Decode86(uint32_t IP, uint16_t CS, Dc86 &D) {
+   uint32_t P = IP;
+   D.Name = nullptr, D.Target = 0, D.Imm = D.Far = 0, D.Disp = 0, D.ImmN = 0, D.Mod = D.Reg = D.Rm = 0, D.Seg = NoSeg, D.Rep = 0, D.Lock = 0;
+// The prefixes, up to the longest opcode that the processor takes in.
+   while (D.Op = Get86(P++), D.Info = &Ops86[D.Op], D.Info->Form == XPre && P - IP < 0x10)
+      if (D.Op == 0360) D.Lock = 1; else if ((D.Op&0376) == 0362) D.Rep = D.Op; else D.Seg = (D.Op >> 3)&3;
+   uint8_t Form = D.Info->Form; D.Flow = D.Info->Flow;
+   bool Ok = Form != XBad && Form != XPre;
+   if (Form == XR || Form == XRB || Form == XRW) {
+      uint8_t M = Get86(P++); D.Mod = M >> 6, D.Reg = (M >> 3)&7, D.Rm = M&7;
+      if (D.Mod == 1) D.Disp = (int8_t)Get86(P++);
+      else if (D.Mod == 2 || D.Mod == 0 && D.Rm == 6) D.Disp = Get86(P) | Get86(P + 1) << 8, P += 2;
+      uint8_t Gp = D.Info->Group;
+      if (Gp != GpNone) {
+         D.Name = GpName[Gp][D.Reg];
+      // Group 7 with a byte operand only has ‟INC” and ‟DEC”; ‟TEST” in group 6 has an immediate operand; ‟JMP Ew” and ‟JMP Mf” are indirect.
+         if (D.Name == nullptr || Gp == Gp7 && !(D.Op&1) && D.Reg >= 2) Ok = false;
+         else if (Gp == Gp6 && D.Reg < 2) Form = D.Op&1? XRW: XRB;
+         else if (Gp == Gp7 && (D.Reg == 4 || D.Reg == 5)) D.Flow = FlJumpInd;
+      }
+   // ‟MOV CS,Ew” jumps.
+      else if (D.Op == 0216 && (D.Reg&3) == 1) D.Flow = FlJumpInd;
+   }
+   switch (Form) {
+      case XB: case XRB: D.Imm = Get86(P++), D.ImmN = 1; break;
+      case XW: case XRW: case XAw: D.Imm = Get86(P) | Get86(P + 1) << 8, P += 2, D.ImmN = 2; break;
+      case XJs: D.Imm = (int8_t)Get86(P++); break;
+      case XJw: D.Imm = Get86(P) | Get86(P + 1) << 8, P += 2; break;
+      case XAf: D.Imm = Get86(P) | Get86(P + 1) << 8, D.Far = Get86(P + 2) | Get86(P + 3) << 8, P += 4; break;
+   }
+   D.Len = P - IP;
+// A near target is an offset in CS, wrapping around within it.
+   if (Form == XJs || Form == XJw) D.Target = Linear(CS, uint16_t(IP - (CS << 4)) + D.Len + D.Imm);
+   else if (Form == XAf) D.Target = Linear(D.Far, D.Imm);
+   return Ok;
+}
+
+// The code segment for an opcode not reached by the flow: that of the 64K bank that holds it, as for the BIOS at F000.
+static inline uint16_t BankCS(uint32_t IP) { return (IP >> 4)&0xf000; }
+
+// Disassemble D into Buf; return the length of the text.
+static size_t Disassemble86(const Dc86 &D, char *Buf, size_t BufN) {
+   static const char *Rb[8] = { "AL", "CL", "DL", "BL", "AH", "CH", "DH", "BH" }, *Rw[8] = { "AX", "CX", "DX", "BX", "SP", "BP", "SI", "DI" };
+   static const char *Rs[4] = { "ES", "CS", "SS", "DS" }, *Ea[8] = { "BX+SI", "BX+DI", "BP+SI", "BP+DI", "SI", "DI", "BP", "BX" };
+   static const char Hex[] = "0123456789ABCDEF";
+   uint8_t Form = D.Info->Form;
+   bool Mem = (Form == XR || Form == XRB || Form == XRW) && D.Mod != 3 || Form == XAw;
+   char *BP = Buf, *EndP = Buf + BufN - 1;
+#define Put(Ch) (BP < EndP? *BP++ = (Ch): 0)
+   auto PutStr = [&](const char *S) { while (*S != '\0') Put(*S++); };
+   if (D.Lock) PutStr("LOCK ");
+   if (D.Rep) PutStr(D.Rep == 0362? "REPNE ": (D.Op&0366) == 0246? "REPE ": "REP ");
+// A segment override without a memory operand to show it on, as for the string opcodes.
+   if (D.Seg != NoSeg && !Mem) PutStr(Rs[D.Seg]), PutStr(": ");
+   for (const char *TP = D.Info->Text; *TP != '\0'; TP++) {
+      if (*TP != '%') { Put(*TP); continue; }
+      const char *S = nullptr; unsigned Pad = 0, Num = 0, Digits = 0;
+      switch (*++TP) {
+         case 'e': case 'E':
+            if (D.Mod == 3) { S = *TP == 'E'? Rw[D.Rm]: Rb[D.Rm]; break; }
+            if (D.Info->Group != GpNone && !(D.Info->Group == Gp7 && (D.Reg == 3 || D.Reg == 5))) PutStr(*TP == 'E'? "WORD ": "BYTE ");
+            if (D.Seg != NoSeg) PutStr(Rs[D.Seg]), Put(':');
+            Put('[');
+            if (D.Mod == 0 && D.Rm == 6) Put('$'), Num = uint16_t(D.Disp), Digits = 4;
+            else {
+               PutStr(Ea[D.Rm]);
+               if (D.Mod == 1) Put(D.Disp >= 0? '+': '-'), Put('$'), Num = D.Disp >= 0? D.Disp: -D.Disp, Digits = 2;
+               else if (D.Mod == 2) Put('+'), Put('$'), Num = uint16_t(D.Disp), Digits = 4;
+            }
+            while (Digits > 0) Digits--, Put(Hex[(Num >> 4*Digits)&0xf]);
+            Put(']');
+         break;
+         case 'g': S = Rb[D.Reg]; break;
+         case 'G': S = Rw[D.Reg]; break;
+         case 'S': S = Rs[D.Reg&3]; break;
+         case 'q': S = Rb[D.Op&7]; break;
+         case 'r': S = Rw[D.Op&7]; break;
+         case 'b': Put('$'), Num = D.Imm, Digits = 2; break;
+         case 'w': Put('$'), Num = D.Imm, Digits = 4; break;
+         case 's': if (D.Imm&0x80) Put('-'), Put('$'), Num = 0x100 - D.Imm, Digits = 2; else Put('$'), Num = D.Imm, Digits = 2; break;
+         case 'i': if (D.ImmN > 0) Put(','), Put('$'), Num = D.Imm, Digits = 2*D.ImmN; break;
+         case 'j': Put(NumPre), Num = D.Target, Digits = 5; break;
+         case 'a': Put('$'), Num = (uint32_t)D.Far << 16 | D.Imm, Digits = 8; break;
+         case 'm':
+            if (D.Seg != NoSeg) PutStr(Rs[D.Seg]), Put(':');
+            Put('['), Put('$'), Num = D.Imm, Digits = 4;
+            while (Digits > 0) Digits--, Put(Hex[(Num >> 4*Digits)&0xf]);
+            Put(']');
+         break;
+         case 'x': S = D.Name, Pad = 8; break;
+         case 'o': Put('$'), Num = (D.Op&7) << 3 | D.Reg, Digits = 2; break;
+      }
+      if (S != nullptr) for (unsigned N = 0; *S != '\0' || N < Pad; N++) Put(*S != '\0'? *S++: ' ');
+      while (Digits > 0) {
+         Digits--, Put(Hex[(Num >> 4*Digits)&0xf]);
+      // A far address, as segment:offset.
+         if (*TP == 'a' && Digits == 4) Put(':'), Put('$');
+      }
+   }
+#undef Put
+   *BP = '\0';
+   return BP - Buf;
+}
+
+// A pending address on the work list of OpScan86().
+struct ScanItem86 {
+   uint32_t IP, From;	// The address and the opcode that it was reached from.
+   uint16_t CS;		// The code segment there.
+   uint8_t Why;		// How it was reached (ScanWhy).
+};
+static ScanItem86 *ScanList86; static uint32_t ScanMax86;
+
+// Follow the program flow from IP, in the code segment CS, as OpScan() does; the paths end at the edges of the image.
+static void OpScan86(uint32_t IP, uint16_t CS, ScanWhy Why) {
+   uint32_t ScanN = 0, From = IP;
+   bool Label = true;
+   Dc86 D;
+   while (true) {
+      bool End = false;
+      if (IP < LoRAM || IP > HiRAM) End = true;
+      else {
+      // Mark address references to the opcode area.
+         if (Label) Mode[IP] |= 0x10;
+      // Break out upon reaching an already-processed code area.
+         if ((Mode[IP]&0x0f) == Opcode) End = true;
+      // Abort upon finding an operator/operand collision; i.e. overlapping opcode areas.
+         else if ((Mode[IP]&0x0f) == Operand) {
+            printf("Illegal jump at addr %5.5XH (%s from %5.5XH)\n", IP, WhyName[Why], From);
+            End = true;
+         }
+      // Abort upon finding a byte that is not an opcode of the processor.
+         else if (!Decode86(IP, CS, D)) {
+            printf("Illegal opcode at addr %5.5XH (%s from %5.5XH)\n", IP, WhyName[Why], From);
+            End = true;
+         }
+      }
+      if (!End) {
+      // Mark the opcode area as an operator followed by operands.
+         Mode[IP] = Opcode | (Label? 0x10: 0), Seg86[IP] = CS, Label = false;
+         for (uint32_t n = 1; n < D.Len; n++) Mode[(IP + n)&(Space86 - 1)] = Operand;
+         uint32_t IP0 = IP, NextIP = Linear(CS, uint16_t(IP - (CS << 4)) + D.Len); // Save the next opcode.
+         uint16_t NextCS = D.Info->Form == XAf? D.Far: CS;
+         Why = ByFlow;
+         switch (D.Flow) {
+         // Jcc Js; loop Js; jcxz Js; call Jw; call Af: scan the target first, then the next opcode.
+            case FlBranch: case FlCall:
+               if (ScanN >= ScanMax86) {
+                  ScanMax86 = ScanMax86 == 0? 0x100: 2*ScanMax86;
+                  ScanList86 = (ScanItem86 *)realloc(ScanList86, ScanMax86*sizeof *ScanList86); if (ScanList86 == nullptr) exit(1);
+               }
+               ScanList86[ScanN].IP = NextIP, ScanList86[ScanN].From = IP0, ScanList86[ScanN].CS = CS, ScanList86[ScanN++].Why = ByFlow;
+               NextIP = D.Target, CS = NextCS, Why = D.Flow == FlCall? ByCall: ByBranch, Label = true;
+            break;
+         // jmp Js; jmp Jw; jmp Af
+            case FlJump: NextIP = D.Target, CS = NextCS, Why = ByJump, Label = true; break;
+         // ret; retf; iret; jmp Ew; jmp Mf; pop CS; mov CS,Ew
+            case FlRet: case FlJumpInd: End = true; break;
+         }
+         From = IP0, IP = NextIP;
+      }
+   // At the end of a path, resume with the latest address pushed.
+      if (End) {
+         if (ScanN == 0) return;
+         const ScanItem86 &Item = ScanList86[--ScanN];
+         IP = Item.IP, From = Item.From, CS = Item.CS, Why = (ScanWhy)Item.Why, Label = Why != ByFlow;
+      }
+   }
+}
+
+// Parse the program flow of the image from Entry, in the code segment CS, and, with DoParseInt, from the interrupt vectors.
+static void ParseFlow86(uint32_t Entry, uint16_t CS, bool DoParseInt) {
+// All data, by starting default.
+   for (uint32_t IP = LoRAM; IP <= HiRAM; IP++) Mode[IP] = Data;
+   if (DoParseInt && LoRAM == 0 && HiRAM >= 0x3ff)
+      for (uint32_t V = 0; V < 0x400; V += 4) {
+         uint16_t Off = Code[V] | Code[V + 1] << 8, Seg = Code[V + 2] | Code[V + 3] << 8; uint32_t IP = Linear(Seg, Off);
+         if (IP >= 0x400 && IP <= HiRAM && (Mode[IP]&0x0f) == Data) OpScan86(IP, Seg, ByVector);
+      }
+   OpScan86(Entry, CS, ByStart);
+}
+
+// The start of the line after the one starting at IP.
+static uint32_t NextLine86(uint32_t IP) {
+   if ((Mode[IP]&0x0f) == Data) {
+      uint32_t Lo = IP;
+      while (IP - Lo < 16 && IP <= HiRAM && (Mode[IP]&0x0f) == Data) IP++;
+      return IP;
+   }
+   Dc86 D;
+   return Decode86(IP, (Mode[IP]&0x0f) == Opcode? Seg86[IP]: BankCS(IP), D)? IP + D.Len: IP + 1;
+}
+
+static char *PutLabel86(char *P, uint32_t IP, char Pre) { *P++ = Pre, *P++ = Hex2.D[IP >> 16&0xf][1]; return PutS(PutW(P, IP), ": ", 2); }
+
+static void Render86(Chunk &C) {
+   OutBuf &B = C.Text;
+   const size_t LineMax = 0x200; // More than the longest line.
+   for (uint32_t IP = C.Lo, Next; IP < C.Hi && IP <= HiRAM; IP = Next) {
+      Next = NextLine86(IP);
+      char *P = Room(B, LineMax);
+      if ((Mode[IP]&0x0f) == Data) {
+         P = PutLabel86(P, IP, 'L'), P = PutS(P, "DEFB    ", 8);
+         for (uint32_t n = IP; n < Next; n++) {
+            if (n > IP) *P++ = ',';
+            *P++ = '$', P = PutB(P, Code[n]);
+         }
+      } else {
+         uint32_t N = Next - IP;
+         if (!OutHex) P = Mode[IP]&0x10? PutLabel86(P, IP, OutParse? 'L': '$'): PutS(P, "        ", 8);
+         else {
+            *P++ = OutParse? 'L': '$', *P++ = Hex2.D[IP >> 16&0xf][1], P = PutW(P, IP), P = PutS(P, "  ", 2);
+            for (uint32_t n = 0; n < N; n++) P = PutB(P, Get86(IP + n)), *P++ = ' ';
+            for (uint32_t n = 6; n > N; n--) P = PutS(P, "   ", 3);
+            P = PutS(P, "    ", 4);
+         }
+         Dc86 D;
+         if (Decode86(IP, (Mode[IP]&0x0f) == Opcode? Seg86[IP]: BankCS(IP), D)) P += Disassemble86(D, P, 0x100);
+         else P = PutS(P, "DEFB    $", 9), P = PutB(P, Code[IP]);
+      }
+      *P++ = '\n', B.N = P - B.Buf;
+   }
+}
+
+// Load, parse and write out the image of an 8086 or 8088, from Start, with ThreadN threads.
+static int Das86(char *InFile, FILE *ExF, uint32_t Offset, uint32_t Start, int Fill, bool DoParse, bool DoParseInt, unsigned ThreadN) {
+   SpaceN = Space86, LoRAM = Space86, HiRAM = 0;
+   Code = (uint8_t *)malloc(Space86), Mode = (uint8_t *)calloc(Space86, 1), Seg86 = (uint16_t *)calloc(Space86, sizeof *Seg86);
+   if (Code == nullptr || Mode == nullptr || Seg86 == nullptr) exit(1);
+   memset(Code, Fill, Space86);
+   if (!LoadBin(InFile, Offset)) return 1;
+   if (Start > HiRAM) {
+      fprintf(stderr, "Error: the start %05X lies after the end of the image at %05X\n", Start, HiRAM);
+      return 1;
+   }
+   if (DoParse) {
+      uint32_t Entry = HexEntry != ~0U? HexEntry: LoRAM <= 0xffff0 && HiRAM >= 0xffff0? 0xffff0: LoRAM;
+      ParseFlow86(Entry, HexEntry != ~0U? HexEntryCS: BankCS(Entry), DoParseInt);
+   }
+   uint32_t IP = Start >= LoRAM? Start: LoRAM;
+   fprintf(ExF, "        ORG     $%05X\n", IP);
+// Lay the chunks out, as in WriteLines().
+   uint32_t ChunkSize = (HiRAM + 1 - IP)/(4*ThreadN) + 1;
+   Chunk *Chunks = nullptr; unsigned ChunkN = 0, ChunkMax = 0;
+   for (uint32_t Lo = IP; IP <= HiRAM; ) {
+      IP = NextLine86(IP);
+      if (IP - Lo < ChunkSize && IP <= HiRAM) continue;
+      if (ChunkN >= ChunkMax) {
+         ChunkMax = ChunkMax == 0? 0x40: 2*ChunkMax;
+         Chunks = (Chunk *)realloc(Chunks, ChunkMax*sizeof *Chunks); if (Chunks == nullptr) exit(1);
+      }
+      Chunk &C = Chunks[ChunkN++]; C.Lo = Lo, C.Hi = IP, C.Text = OutBuf{ nullptr, 0, 0 };
+      Lo = IP;
+   }
+   PutChunks(ExF, Chunks, ChunkN, ThreadN, Render86);
+   return 0;
+}
+
 // Read, parse, disassemble and output.
 int main(int AC, char *AV[]) {
-   char *InFile = 0, *ExFile = 0;
-   bool DoHex = false, DoParse = false, DoParseInt = false;
+   char *InFile = 0, *ExFile = 0, *GraphFile = nullptr, *DiffFile = nullptr, *ProjFile = nullptr;
+   bool DoHex = false, DoText = false, DoParse = false, DoParseInt = false, DoGuess = false, DoTime = false, DoOff = false, DoDepth = false;
    fprintf(stderr, "DasZ80 - small disassembler for Z80 code\n");
    fprintf(stderr, "Based on TurboDis Z80 by Markus Fritze\n");
    uint32_t Offset = 0, Start = 0;
    int Fill = 0;
+   unsigned ThreadN = std::thread::hardware_concurrency();
    for (int A = 1, Ax = 0; A < AC; A++)
-      if (AV[A][0] == '-') {
+      if (AV[A][0] == '-' && AV[A][1] != '\0') {
          switch (AV[A][++Ax]) {
          // Fill.
             case 'f': {
@@ -552,7 +3299,7 @@ int main(int AC, char *AV[]) {
                if (AV[A][++Ax] != '\0') InN = sscanf(AV[A] + Ax, "%x", &Offset);
             // "-o XXXX"
                else if (A < AC - 1) InN = sscanf(AV[++A], "%x", &Offset);
-               if (InN > 0) Offset &= 0xffff; // Limit to 64K.
+               if (InN > 0) Offset &= 0xfffff; // Limit to 1M, and to 64K below, but for the 8086 and 8088.
                else {
                   fprintf(stderr, "Error: option -o needs a hexadecimal argument\n");
                   return 1;
@@ -567,7 +3314,7 @@ int main(int AC, char *AV[]) {
                if (AV[A][++Ax] != '\0') InN = sscanf(AV[A] + Ax, "%x", &Start);
             // "-s XXXX"
                else if (A < AC - 1) InN = sscanf(AV[++A], "%x", &Start);
-               if (InN > 0) Start &= 0xffff; // Limit to 64K.
+               if (InN > 0) Start &= 0xfffff; // Limit to 1M, and to 64K below, but for the 8086 and 8088.
                else {
                   fprintf(stderr, "Error: option -s needs a hexadecimal argument\n");
                   return 1;
@@ -575,11 +3322,152 @@ int main(int AC, char *AV[]) {
                Ax = 0; // The end of this arg group.
             }
             break;
+         // Entry points.
+            case 'e': {
+               int InN = 0; unsigned Entry = 0;
+            // "-eXXXX"
+               if (AV[A][++Ax] != '\0') InN = sscanf(AV[A] + Ax, "%x", &Entry);
+            // "-e XXXX"
+               else if (A < AC - 1) InN = sscanf(AV[++A], "%x", &Entry);
+               if (InN <= 0 || Entry >= CodeMax) {
+                  fprintf(stderr, "Error: option -e needs a hexadecimal argument\n");
+                  return 1;
+               }
+               AddEntry(Entry), DoParse = true, NumPre = 'L';
+               Ax = 0; // The end of this arg group.
+            }
+            break;
+         // Banks.
+            case 'b': case 'w': {
+               char Opt = AV[A][Ax];
+               uint32_t &Arg = Opt == 'b'? BankSize: BankWin;
+               int InN = 0;
+            // "-bXXXX"
+               if (AV[A][++Ax] != '\0') InN = sscanf(AV[A] + Ax, "%x", &Arg);
+            // "-b XXXX"
+               else if (A < AC - 1) InN = sscanf(AV[++A], "%x", &Arg);
+               if (InN <= 0 || Arg > (Opt == 'b'? CodeMax: CodeMax - 1) || Opt == 'b' && Arg == 0) {
+                  fprintf(stderr, "Error: option -%c needs a hexadecimal argument\n", Opt);
+                  return 1;
+               }
+               Ax = 0; // The end of this arg group.
+            }
+            break;
          // Parse the program flow.
             case 'p': DoParse = true, NumPre = 'L'; break;
          // Parse the program flow.
             case 'r': DoParseInt = true; break;
+         // Guess more code.
+            case 'g': DoGuess = DoParse = true, NumPre = 'L'; break;
             case 'x': DoHex = true; break;
+         // Text, fills and words.
+            case 'a': DoText = true; break;
+         // Timing.
+            case 't': DoTime = DoParse = true, NumPre = 'L'; break;
+         // Interrupt latency.
+            case 'i': DoOff = DoParse = true, NumPre = 'L'; break;
+         // Stack depth.
+            case 'd': DoDepth = DoParse = true, NumPre = 'L'; break;
+         // Symbols.
+            case 'y': {
+               const char *SymFile = nullptr;
+            // "-yFile"
+               if (AV[A][++Ax] != '\0') SymFile = AV[A] + Ax;
+            // "-y File"
+               else if (A < AC - 1) SymFile = AV[++A];
+               if (SymFile == nullptr) {
+                  fprintf(stderr, "Error: option -y needs a file name\n");
+                  return 1;
+               }
+               if (!LoadSymbols(SymFile)) return 1;
+               Ax = 0; // The end of this arg group.
+            }
+            break;
+         // Signatures.
+            case 'm': {
+               const char *SigFile = nullptr;
+            // "-mFile"
+               if (AV[A][++Ax] != '\0') SigFile = AV[A] + Ax;
+            // "-m File"
+               else if (A < AC - 1) SigFile = AV[++A];
+               if (SigFile == nullptr) {
+                  fprintf(stderr, "Error: option -m needs a file name\n");
+                  return 1;
+               }
+               if (!LoadSignatures(SigFile)) return 1;
+               Ax = 0; // The end of this arg group.
+            }
+            break;
+         // The processor, "-cpu 8080|8085|8088|Z80", or else the control flow graph.
+            case 'c': {
+               if (strcmp(AV[A] + Ax, "cpu") == 0 && A < AC - 1) {
+                  const char *Cpu = AV[++A];
+                  Cpu86 = false;
+                  if (strcmp(Cpu, "8080") == 0) BasePg = Pg8080;
+                  else if (strcmp(Cpu, "8085") == 0) BasePg = Pg8085;
+                  else if (strcmp(Cpu, "8086") == 0 || strcmp(Cpu, "8088") == 0) BasePg = PgBase, Cpu86 = true;
+                  else if (strcmp(Cpu, "Z80") == 0 || strcmp(Cpu, "z80") == 0) BasePg = PgBase;
+                  else {
+                     fprintf(stderr, "Error: option -cpu needs 8080, 8085, 8088 or Z80\n");
+                     return 1;
+                  }
+                  Ax = 0; // The end of this arg group.
+                  break;
+               }
+            // "-cFile"
+               if (AV[A][++Ax] != '\0') GraphFile = AV[A] + Ax;
+            // "-c File"
+               else if (A < AC - 1) GraphFile = AV[++A];
+               if (GraphFile == nullptr) {
+                  fprintf(stderr, "Error: option -c needs a file name\n");
+                  return 1;
+               }
+               DoParse = true, NumPre = 'L';
+               Ax = 0; // The end of this arg group.
+            }
+            break;
+         // The older image to compare against.
+            case 'v': {
+            // "-vFile"
+               if (AV[A][++Ax] != '\0') DiffFile = AV[A] + Ax;
+            // "-v File"
+               else if (A < AC - 1) DiffFile = AV[++A];
+               if (DiffFile == nullptr) {
+                  fprintf(stderr, "Error: option -v needs a file name\n");
+                  return 1;
+               }
+               DoParse = true, NumPre = 'L';
+               Ax = 0; // The end of this arg group.
+            }
+            break;
+         // The project.
+            case 'k': {
+            // "-kFile"
+               if (AV[A][++Ax] != '\0') ProjFile = AV[A] + Ax;
+            // "-k File"
+               else if (A < AC - 1) ProjFile = AV[++A];
+               if (ProjFile == nullptr) {
+                  fprintf(stderr, "Error: option -k needs a file name\n");
+                  return 1;
+               }
+               DoParse = true, NumPre = 'L';
+               Ax = 0; // The end of this arg group.
+            }
+            break;
+         // Threads.
+            case 'j': {
+               int InN = 0;
+            // "-jN"
+               if (AV[A][++Ax] != '\0') InN = sscanf(AV[A] + Ax, "%u", &ThreadN);
+            // "-j N"
+               else if (A < AC - 1) InN = sscanf(AV[++A], "%u", &ThreadN);
+               if (InN <= 0 || ThreadN < 1) {
+                  fprintf(stderr, "Error: option -j needs a positive number\n");
+                  return 1;
+               }
+               Ax = 0; // The end of this arg group.
+            }
+            break;
             default: Usage(AV[0]); return 1;
          }
       // If one more arg char, keep this arg group.
@@ -589,54 +3477,121 @@ int main(int AC, char *AV[]) {
       else if (ExFile == nullptr) ExFile = AV[A];
    // Check the next arg string.
       else { Usage(AV[0]); return 1; }
-   memset(Code, Fill, sizeof Code);
-   memset(Mode, Empty, sizeof Mode);
+   if (ThreadN == 0) ThreadN = 1;
+   if (InFile != nullptr && strcmp(InFile, "-") == 0) {
+      if (Cpu86 || DoParse || DoParseInt || DoText || BankSize > 0 || SigN > 0 || SymN > 0 || Start != 0) {
+         fprintf(stderr, "Error: only the options -f, -o, -x, -j and -cpu 8080|8085 work on the standard input\n");
+         return 1;
+      }
+#ifdef _WIN32
+      _setmode(_fileno(stdin), _O_BINARY);
+#endif
+      FILE *ExF = ExFile? fopen(ExFile, "w"): stdout;
+      if (ExF == nullptr) {
+         fprintf(stderr, "Error: cannot open outfile \"%s\"\n", ExFile);
+         return 1;
+      }
+      OutHex = DoHex;
+      int Status = DasStream(fileno(stdin), ExF, Offset&0xffff, Fill);
+      fclose(ExF);
+      return Status;
+   }
+   if (Cpu86) {
+      if (BankSize > 0 || DoGuess || DoTime || DoOff || DoDepth || DoText || GraphFile != nullptr || DiffFile != nullptr || SigN > 0 || SymN > 0 || EntryN > 0 || ProjFile != nullptr) {
+         fprintf(stderr, "Error: options -b, -g, -m, -c, -t, -i, -d, -a, -y, -v, -e and -k are only for the Z80, 8080 and 8085\n");
+         return 1;
+      }
+      FILE *ExF = ExFile? fopen(ExFile, "w"): stdout;
+      if (ExF == nullptr) {
+         fprintf(stderr, "Error: cannot open outfile \"%s\"\n", ExFile);
+         return 1;
+      }
+      OutHex = DoHex, OutParse = DoParse;
+      int Status = Das86(InFile, ExF, Offset, Start, Fill, DoParse, DoParseInt, ThreadN);
+      fclose(ExF);
+      return Status;
+   }
+   Offset &= 0xffff, Start &= 0xffff;
+   if (BankSize > 0 && (EntryN > 0 || ProjFile != nullptr)) {
+      fprintf(stderr, "Error: options -e and -k need an image without banks\n");
+      return 1;
+   }
+   if (DiffFile != nullptr) {
+      if (BankSize > 0) {
+         fprintf(stderr, "Error: option -v needs an image without banks\n");
+         return 1;
+      }
+   // The older image, parsed and summed up in a view of its own, before the image itself is loaded.
+      View *Old = NewView(Fill);
+      if (!LoadBin(DiffFile, Offset)) return 1;
+      ParseFlow(LoRAM, DoParseInt, DoGuess), BuildGraph(), SumRoutines(Olds);
+      free(Old), LoRAM = CodeMax, HiRAM = 0;
+   }
+   View *V = NewView(Fill);
    if (!LoadBin(InFile, Offset)) return 1;
    Offset = LoRAM;
-   uint32_t CodeN = HiRAM + 1;
-   if (DoParse) {
-   // All data, by starting default.
-      for (uint32_t IP = LoRAM; IP <= HiRAM; IP++) Mode[IP] = Data;
-      if (DoParseInt) {
-      // Parse the rst vectors, if needed.
-         for (int IP = 0; IP < 0100; IP += 010) if ((Mode[IP]&0x0f) == Data) OpScan(IP);
-      // Also, parse the NMI vector, if needed.
-         if ((Mode[0146]&0x0f) == Data) OpScan(0146);
-      }
-      OpScan(LoRAM);
+   if (Start > HiRAM) {
+      fprintf(stderr, "Error: the start %04X lies after the end of the image at %04X\n", Start, HiRAM);
+      return 1;
+   }
+   uint32_t Fixed = BankSize < ImageN? BankSize: ImageN; // The size of bank 0.
+   if (BankSize > 0 && BankWin == CodeMax) BankWin = ImageAt + BankSize;
+   if (BankSize > 0 && (ImageAt + Fixed > CodeMax || BankWin + BankSize > CodeMax || BankWin != ImageAt && BankWin < ImageAt + Fixed)) {
+      fprintf(stderr, "Error: the banks of %04X bytes at %04X and %04X do not fit into the 64K address space\n", BankSize, ImageAt, BankWin);
+      return 1;
    }
    FILE *ExF = ExFile? fopen(ExFile, "w"): stdout;
    if (ExF == nullptr) {
       fprintf(stderr, "Error: cannot open outfile \"%s\"\n", ExFile);
       return 1;
    }
-   uint32_t IP = Start >= Offset? Start: Offset;
-   fprintf(ExF, "        ORG     $%04X\n", IP);
-   while (IP <= HiRAM)
-      if ((Mode[IP]&0x0f) == Data) {
-         fprintf(ExF, "L%4.4X:  DEFB", (uint16_t)IP);
-         for (uint32_t n = 0; n < 16; IP++, n++) {
-            if ((Mode[IP]&0x0f) != Data || IP >= CodeN) break;
-            fprintf(ExF, "%s$%2.2X", n? ",": "    ", Code[IP]);
-         }
-         fprintf(ExF, "\n");
-      } else {
-         uint32_t N = OpLen(IP); // Get the opcode length.
-         if (!DoHex) {
-            if (Mode[IP]&0x10) fprintf(ExF, "%c%4.4X:  ", DoParse? 'L': '$', IP);
-            else fprintf(ExF, "        ");
-         } else {
-            fprintf(ExF, "%c%4.4X   ", DoParse? 'L': '$', (uint16_t)IP);
-            for (uint32_t n = 0; n < N; n++) fprintf(ExF, "%2.2X ", Code[IP + n]);
-            for (uint32_t n = 4; n > N; n--) fprintf(ExF, "   ");
-            fprintf(ExF, "    ");
-         }
-         char Line[0x100]; // The output string.
-         Disassemble(IP, Line, sizeof Line);
-         fprintf(ExF, "%s\n", Line);
-         IP += N;
+   FILE *GraphF = nullptr; bool Json = false;
+   if (GraphFile != nullptr) {
+      Json = strlen(GraphFile) > 5 && strcmp(GraphFile + strlen(GraphFile) - 5, ".json") == 0;
+      if ((GraphF = fopen(GraphFile, "w")) == nullptr) {
+         fprintf(stderr, "Error: cannot open graph file \"%s\"\n", GraphFile);
+         return 1;
+      }
+   }
+   OutHex = DoHex, OutText = DoText, OutParse = DoParse;
+   if (SigN > 0) MatchSignatures(Image != nullptr? Image: Code + LoRAM, Image != nullptr? ImageN: HiRAM + 1 - LoRAM);
+   if (BankSize == 0) {
+      bool Kept = false;
+      if (ProjFile != nullptr && !LoadProject(ProjFile, Kept)) return 1;
+      NameSignatures(0, HiRAM + 1 - LoRAM, LoRAM);
+      if (DoParse) ParseFlow(LoRAM, DoParseInt, DoGuess, !Kept, true), KeepData();
+      if (ProjFile != nullptr && !SaveProject(ProjFile)) return 1;
+      if (GraphF != nullptr || DoTime || DoOff || DoDepth || DiffFile != nullptr) BuildGraph();
+      if (GraphF != nullptr) WriteGraph(GraphF, Json);
+      if (DoTime || DoOff || DoDepth) BoundRoutines(ExF, LoRAM, DoTime, DoOff, DoDepth);
+      if (DiffFile != nullptr) DiffRoutines(ExF, DiffFile);
+      ProjectNotes();
+      uint32_t IP = Start >= Offset? Start: Offset;
+      fprintf(ExF, "        ORG     $%04X\n", IP);
+      WriteLines(ExF, IP, ThreadN);
+   } else {
+      View *Fix = nullptr; // The view of the fixed bank.
+      uint32_t FixNamedN = 0; // The names that it has from signatures.
+      for (uint32_t Bank = 0, BankN = (ImageN - 1)/BankSize + 1; Bank < BankN; Bank++) {
+         uint32_t At = Bank == 0? ImageAt: BankWin, N = ImageN - Bank*BankSize < BankSize? ImageN - Bank*BankSize: BankSize;
+         if (Bank > 0) V = NewView(Fill);
+         memcpy(Code + At, Image + Bank*BankSize, N), LoRAM = At, HiRAM = At + N - 1;
+         if (Fix != nullptr)
+            memcpy(Code + ImageAt, Fix->Code + ImageAt, Fixed), memcpy(Mode + ImageAt, Fix->Mode + ImageAt, Fixed), LoRAM = ImageAt;
+         fprintf(ExF, "; Bank %u\n", Bank);
+         DropSignatures(FixNamedN), NameSignatures(Bank*BankSize, N, At);
+         if (DoParse) ParseFlow(At, DoParseInt, DoGuess);
+         if (GraphF != nullptr || DoTime || DoOff || DoDepth) BuildGraph();
+         if (GraphF != nullptr) WriteGraph(GraphF, Json);
+         if (DoTime || DoOff || DoDepth) BoundRoutines(ExF, At, DoTime, DoOff, DoDepth);
+         fprintf(ExF, "        ORG     $%04X\n", At);
+         WriteLines(ExF, At, ThreadN);
+         if (Bank == 0 && BankWin != ImageAt) Fix = V, FixNamedN = SigNamedN; else free(V);
       }
+      free(Fix);
+   }
    fclose(ExF);
+   if (GraphF != nullptr) fclose(GraphF);
 }
 
 // Call-back from HexIn.cpp when data has arrived.
@@ -644,10 +3599,15 @@ bool HexIn::GetData(HexRecordT Type, bool Error) {
    static uint32_t HexDataN = 0;
    Error = Error || _Length < _LineN;
    if (Type == HexLineRec && !Error) {
+      if (HexAddress() + _Length > SpaceN) {
+         fprintf(stderr, "Error: the HEX record of %u bytes at %X lies outside of the %s address space\n", (unsigned)_Length, (unsigned)HexAddress(), SpaceN == CodeMax? "64K": "1M");
+         HexOut = true;
+         return false;
+      }
       memcpy(Code + HexAddress(), _Line, _Length);
       if (HexAddress() < LoRAM) LoRAM = HexAddress();
       if (HexAddress() + _Length >= HiRAM) HiRAM = HexAddress() + _Length - 1;
       HexDataN += _Length;
-   }
+   } else if (Type == HexStartSegRec && !Error && _Length == 4) HexEntryCS = _Line[0] << 8 | _Line[1], HexEntry = Linear(HexEntryCS, _Line[2] << 8 | _Line[3]);
    return !Error;
 }
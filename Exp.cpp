@@ -7,6 +7,24 @@
 static SymbolP ErrSymbol;
 PatchListP LastPatch; // To patch the type for incomplete formulas.
 
+// The patches made by the line being compiled, so that they can be dropped, if an error abandons the line.
+struct LinePatch { SymbolP Sym; PatchListP Patch; };
+static LinePatch LinePatches[80]; static int LinePatchN;
+
+void BegLinePatches(void) { LinePatchN = 0; }
+
+// The last patch made is an older one, moved onto another symbol by ResolvePatches(): it is not the line's own.
+void KeepLastPatch(void) { if (LinePatchN > 0) LinePatchN--; }
+
+// Drop the patches made by the line, latest first: those still on the lists of their symbols.
+void DropLinePatches(void) {
+   while (LinePatchN > 0) {
+      LinePatch &LP = LinePatches[--LinePatchN];
+      for (PatchListP *PatchP = &LP.Sym->Patch; *PatchP != nullptr; PatchP = &(*PatchP)->Next)
+         if (*PatchP == LP.Patch) { *PatchP = LP.Patch->Next, free(LP.Patch->Cmd), free(LP.Patch); break; }
+   }
+}
+
 // Indirect recursion.
 static int32_t GetExp0(CommandP &Cmd);
 
@@ -111,6 +129,7 @@ int32_t GetExp(CommandP &Cmd) {
       Patch->Cmd = NewCmd, Patch->Type = -1, Patch->Addr = 0;
    // Link expression to the symbol and save the entry to correct the type.
       Patch->Next = ErrSymbol->Patch, LastPatch = ErrSymbol->Patch = Patch;
+      if (LinePatchN < int(sizeof LinePatches/sizeof LinePatches[0])) LinePatches[LinePatchN].Sym = ErrSymbol, LinePatches[LinePatchN++].Patch = Patch;
    }
    return Value;
 }
@@ -4,6 +4,7 @@
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
+#include <limits.h>
 
 // clang-format off
 struct ShortSym {
@@ -24,7 +25,9 @@ static const ShortSym Pseudo[] = {
    { _endif, "ENDIF", 0x0000 },
    { _else, "ELSE", 0x0000 },
    { _print, "PRINT", 0x0000 },
-   { _fill, "FILL", 0x0000 }
+   { _fill, "FILL", 0x0000 },
+   { _section, "SECTION", 0x0000 },
+   { _ends, "ENDS", 0x0000 }
 };
 
 #define Mode1(Op) ((Op) << 8)
@@ -94,6 +97,7 @@ static const TokenTable Token[] = {
 
 Command CmdBuf[80];	// A tokenized line.
 SymbolP SymTab[0x100];	// The symbol table (split by the upper hash byte).
+uint8_t PCRefs[80], PCRefN; // The tokens in CmdBuf that stand for "$", to rebase the line for the other variants.
 
 // Calculate a simple hash for a string.
 static uint16_t CalcHash(const char *Name) {
@@ -110,9 +114,8 @@ static uint16_t CalcHash(const char *Name) {
    return Hash;
 }
 
-// Search for a symbol, generate one if it didn't already exist.
-static SymbolP FindSymbol(const char *Name) {
-   uint16_t Hash = CalcHash(Name); // A hash value for the name.
+// Search for a symbol with a given hash value, generate one if it didn't already exist.
+static SymbolP FindSymbol(const char *Name, uint16_t Hash) {
    uint8_t HashB = Hash;
 // Search each symbol with a matching hash for a match by name.
    for (SymbolP Sym = SymTab[HashB]; Sym != nullptr; Sym = Sym->Next)
@@ -126,6 +129,9 @@ static SymbolP FindSymbol(const char *Name) {
    return Sym;
 }
 
+// Search for a symbol, generate one if it didn't already exist.
+static SymbolP FindSymbol(const char *Name) { return FindSymbol(Name, CalcHash(Name)); }
+
 // Initialize the symbol table.
 void InitSymTab(void) {
 // Reset all entries.
@@ -142,10 +148,49 @@ void InitSymTab(void) {
 // Lump the underscore '_' in with alphanumeric characters.
 static int IsAlNum(char Ch) { return isalnum(Ch) || Ch == '_'; }
 
+// The copy of a symbol for variant V; variant 0 uses the symbol itself.
+// The copies are made on first use, undefined.
+SymbolP VarSymbol(SymbolP Sym, int V) {
+   if (V == 0) return Sym;
+   if (Sym->Var == nullptr) {
+      Sym->Var = (SymbolP)calloc(VarN - 1, sizeof *Sym); if (Sym->Var == nullptr) exit(1);
+      for (int W = 1; W < VarN; W++) {
+         SymbolP VSym = &Sym->Var[W - 1];
+         VSym->Hash = Sym->Hash, VSym->Type = Sym->Type, strcpy(VSym->Name, Sym->Name);
+      }
+   }
+   return &Sym->Var[V - 1];
+}
+
+// Copy the symbols defined so far (e.g. from snapshots) to all the variants.
+void SplitSymbols(void) {
+   for (int S = 0; S < 0x100; S++) for (SymbolP Sym = SymTab[S]; Sym != nullptr; Sym = Sym->Next)
+      if (Sym->Type == 0 && Sym->Defined) for (int V = 1; V < VarN; V++) {
+         SymbolP VSym = VarSymbol(Sym, V);
+         VSym->Value = Sym->Value, VSym->Defined = Sym->Defined, VSym->First = Sym->First;
+      }
+}
+
+// Define the symbol Name as Value in variant V, as if by EQU.
+bool DefineSymbol(const char *Name, int32_t Value, int V) {
+   char UpName[NameMax + 1]; int N = 0;
+   for (; Name[N] != '\0'; N++) {
+      if (N >= NameMax || !IsAlNum(Name[N])) return false;
+      UpName[N] = toupper(Name[N]);
+   }
+   UpName[N] = '\0';
+   if (N == 0 || !isalpha(UpName[0]) && UpName[0] != '_') return false;
+   SymbolP Sym = FindSymbol(UpName); if (Sym == nullptr || Sym->Type != 0) return false;
+   SymbolP VSym = VarSymbol(Sym, V); if (VSym->Defined) return false;
+   VSym->Value = Value, VSym->Defined = VSym->First = true;
+   return true;
+}
+
 // Tokenize a single line.
 void TokenizeLine(char *Line) {
    char *BegLine = Line; // Remember the beginning of the line.
    CommandP Cmd = CmdBuf; // A pointer to the command buffer.
+   PCRefN = 0;
    char UpLine[LineMax];
    for (char *LP = UpLine; (*LP++ = toupper(*Line++)) != '\0'; ); // Convert to capital letters.
    Line = UpLine;
@@ -168,7 +213,7 @@ void TokenizeLine(char *Line) {
          Base = 0x10;
       }
       long Value;
-      if (Dollar) Type = NumL, Value = CurPC;
+      if (Dollar) Type = NumL, Value = CurPC, PCRefs[PCRefN++] = Cmd - CmdBuf;
       else if (IsAlNum(Ch)) { // A…Z, a…z, 0⋯9, _.
       // A buffer for the numeral and a pointer to it, initialized at the beginning.
          char NumBuf[LineMax], *NP = NumBuf;
@@ -259,3 +304,96 @@ void TokenizeLine(char *Line) {
    }
    Cmd->Type = BadL, Cmd->Value = 0; // Terminate the command buffer.
 }
+
+// Symbol snapshots.
+// A snapshot holds the defined symbols of a run, in a flat little-endian layout that can be used in place once read (or mapped):
+//	Header:		char Sig[8] = "CasSYM" "\032" "\n"; uint32_t SymN, NameN; uint64_t Hash;
+//	Symbols:	SymN times { uint32_t Name; int32_t Value; uint16_t Type, Hash; }
+//	Names:		NameN bytes of '\0'-terminated names, the first of which is the source the snapshot was made from, as an absolute path,
+//			so that the snapshot can be checked from any working directory.
+// Name is an offset into Names, Hash the symbol's hash value and the header's Hash the hash of the source's text.
+static const char SnapSig[] = "CasSYM" "\032" "\n";
+static const size_t SnapHeadN = 8 + 4 + 4 + 8, SnapSymN = 4 + 4 + 2 + 2;
+
+// The absolute path of File, in Path, or File itself, if it cannot be found.
+static const char *FullPath(const char *File, char *Path) {
+#ifndef _WIN32
+   return realpath(File, Path) != nullptr? Path: File;
+#else
+   return _fullpath(Path, File, PATH_MAX) != nullptr? Path: File;
+#endif
+}
+
+static void PutSnap(uint8_t *&BP, uint64_t Value, int N) { for (; N > 0; N--, Value >>= 8) *BP++ = Value; }
+static uint64_t GetSnap(const uint8_t *BP, int N) {
+   uint64_t Value = 0;
+   for (BP += N; N > 0; N--) Value = Value << 8 | *--BP;
+   return Value;
+}
+
+// Save the defined symbols to a snapshot, stamped with the hash of the source they came from.
+bool SaveSymbols(const char *File, const char *Source, uint64_t Hash) {
+   char Path[PATH_MAX]; Source = FullPath(Source, Path);
+   uint32_t SymN = 0, NameN = strlen(Source) + 1;
+   for (int S = 0; S < 0x100; S++) for (SymbolP Sym = SymTab[S]; Sym != nullptr; Sym = Sym->Next)
+      if (Sym->Type == 0 && Sym->Defined) SymN++, NameN += strlen(Sym->Name) + 1;
+   NameN = (NameN + 3)&~3; // Pad to keep the file size aligned.
+   size_t SnapN = SnapHeadN + SymN*SnapSymN + NameN;
+   uint8_t *Snap = (uint8_t *)calloc(1, SnapN); if (Snap == nullptr) return false;
+   uint8_t *BP = Snap;
+   memcpy(BP, SnapSig, 8), BP += 8, PutSnap(BP, SymN, 4), PutSnap(BP, NameN, 4), PutSnap(BP, Hash, 8);
+   char *Names = (char *)Snap + SnapHeadN + SymN*SnapSymN, *NP = Names;
+   strcpy(NP, Source), NP += strlen(Source) + 1;
+   for (int S = 0; S < 0x100; S++) for (SymbolP Sym = SymTab[S]; Sym != nullptr; Sym = Sym->Next)
+      if (Sym->Type == 0 && Sym->Defined) {
+         PutSnap(BP, NP - Names, 4), PutSnap(BP, (uint32_t)Sym->Value, 4), PutSnap(BP, Sym->Type, 2), PutSnap(BP, Sym->Hash, 2);
+         strcpy(NP, Sym->Name), NP += strlen(Sym->Name) + 1;
+      }
+   FILE *ExF = fopen(File, "wb");
+   bool Ok = ExF != nullptr && fwrite(Snap, 1, SnapN, ExF) == SnapN;
+   if (ExF != nullptr && fclose(ExF) != 0) Ok = false;
+   free(Snap);
+   return Ok;
+}
+
+// Load the symbols of a snapshot straight into the symbol table, without tokenizing the source they came from.
+// The snapshot is stale, and rejected, if its source has changed since.
+// Hash is continued over the snapshot's bytes.
+bool LoadSymbols(const char *File, uint64_t &Hash) {
+   FILE *InF = fopen(File, "rb");
+   if (InF == nullptr) { fprintf(stderr, "Error: cannot open symbol snapshot \"%s\"\n", File); return false; }
+   fseek(InF, 0, SEEK_END); size_t SnapN = ftell(InF); fseek(InF, 0, SEEK_SET);
+   uint8_t *Snap = (uint8_t *)malloc(SnapN + 1);
+   bool Ok = Snap != nullptr && fread(Snap, 1, SnapN, InF) == SnapN && SnapN >= SnapHeadN && memcmp(Snap, SnapSig, 8) == 0;
+   fclose(InF);
+   uint32_t SymN = 0, NameN = 0;
+   if (Ok) SymN = GetSnap(Snap + 8, 4), NameN = GetSnap(Snap + 12, 4), Ok = SnapN == SnapHeadN + (size_t)SymN*SnapSymN + NameN && NameN > 0;
+   if (!Ok) { fprintf(stderr, "Error: \"%s\" is not a symbol snapshot\n", File); free(Snap); return false; }
+   Hash = HashBytes(Hash, Snap, SnapN);
+   const uint8_t *BP = Snap + SnapHeadN;
+   char *Names = (char *)BP + SymN*SnapSymN; Names[NameN - 1] = '\0';
+// Check the snapshot against its source.
+   uint64_t SrcHash = HashInit;
+   FILE *SrcF = fopen(Names, "rb");
+   if (SrcF != nullptr) {
+      char Buf[0x1000];
+      for (size_t BufN; (BufN = fread(Buf, 1, sizeof Buf, SrcF)) > 0; ) SrcHash = HashBytes(SrcHash, Buf, BufN);
+      fclose(SrcF);
+   }
+   if (SrcF == nullptr || SrcHash != GetSnap(Snap + 16, 8)) {
+      fprintf(stderr, "Error: symbol snapshot \"%s\" is stale: \"%s\" has changed\n", File, Names);
+      free(Snap); return false;
+   }
+   for (uint32_t S = 0; S < SymN; S++, BP += SnapSymN) {
+      uint32_t Name = GetSnap(BP, 4);
+      if (Name >= NameN) { Ok = false; break; }
+      SymbolP Sym = FindSymbol(Names + Name, GetSnap(BP + 10, 2)); if (Sym == nullptr) { Ok = false; break; }
+      if (Sym->Type != 0 || Sym->Defined) {
+         fprintf(stderr, "Error: symbol snapshot \"%s\" redefines %s\n", File, Sym->Name);
+         Ok = false; break;
+      }
+      Sym->Value = (int32_t)GetSnap(BP + 4, 4), Sym->Defined = Sym->First = true;
+   }
+   free(Snap);
+   return Ok;
+}
@@ -0,0 +1,200 @@
+// Relocatable sections.
+// ─────────────────────
+// A section, "SECTION" ⋯ "ENDS", is assembled into a staging area above the 64K address space, with its labels left undefined,
+// so that every reference to them goes onto the back-patching lists.
+// After the last line the sections are placed, largest first, each into the lowest gap left free by the fixed code that can hold it,
+// or else after the end of the fixed code.
+// The patches and PC-relative jumps in them are then moved along with them, and their labels are defined, which back-patches the references.
+// Optionally, the sections whose labels are not referenced by the fixed code, or by another section kept, are removed.
+#include "Cas.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+SectionSetP Sections; // The sections of the variant being compiled.
+
+SectionSetP NewSections(void) {
+   SectionSetP Set = (SectionSetP)calloc(1, sizeof *Set); if (Set == nullptr) exit(1);
+   Set->Cur = -1, Set->StagePC = StageBeg;
+   return Set;
+}
+
+// Make room for one more item in an array of Max items of the given size.
+static void *GrowArray(void *Array, int &Max, size_t Size) {
+   Max = Max == 0? 0x10: 2*Max;
+   Array = realloc(Array, Max*Size); if (Array == nullptr) exit(1);
+   return Array;
+}
+
+void BegSection(void) {
+   SectionSetP Set = Sections;
+   if (Set->Cur >= 0) Error("SECTION inside a section");
+   if (Set->SectN >= Set->SectMax) Set->Sects = (Section *)GrowArray(Set->Sects, Set->SectMax, sizeof *Set->Sects);
+   Section *Sect = &Set->Sects[Set->Cur = Set->SectN++];
+   Sect->Stage = Set->StagePC, Sect->Size = 0, Sect->Base = 0, Sect->Live = true, Sect->Placed = false;
+   Set->FixPC = CurPC, CurPC = Sect->Stage;
+}
+
+void EndSection(void) {
+   SectionSetP Set = Sections;
+   if (Set->Cur < 0) Error("ENDS without SECTION");
+   Set->Sects[Set->Cur].Size = CurPC - Set->Sects[Set->Cur].Stage, Set->Cur = -1;
+// Leave a spare byte, so that a label at the end of a section is not also at the start of the next one.
+   Set->StagePC = CurPC + 1, CurPC = Set->FixPC;
+}
+
+void DeferLabel(SymbolP Sym) {
+   SectionSetP Set = Sections;
+   if (Set->LabelN >= Set->LabelMax) Set->Labels = (SymbolP *)GrowArray(Set->Labels, Set->LabelMax, sizeof *Set->Labels);
+   Set->Labels[Set->LabelN++] = Sym;
+// Its staging address, until it is placed.
+   Sym->Value = Set->Cur >= 0? CurPC: Set->StagePC, Sym->Deferred = true;
+}
+
+void MarkUsed(uint32_t Lo, uint32_t Hi) {
+   if (Sections->Cur >= 0) return;
+   if (Hi > StageBeg) Hi = StageBeg;
+   for (uint8_t *Used = Sections->Used; Lo < Hi; Lo++) Used[Lo >> 3] |= 1 << (Lo&7);
+}
+
+static bool IsUsed(uint32_t PC) { return Sections->Used[PC >> 3]&(1 << (PC&7)); }
+
+// The PC-relative byte at Addr has to reach Target.
+static void CheckJump(uint32_t Addr, int32_t Target) {
+   int32_t Ds = Target - int32_t(Addr + 1);
+   if (Ds < -0x80 || Ds >= 0x80) JumpError(Addr);
+}
+
+// A jump from a section out of the sections is taken relative to its staging address, so it is redone, and checked, after the placement.
+void NoteJump(uint32_t Addr, int32_t Target) {
+   SectionSetP Set = Sections;
+   if (Addr < StageBeg || Target >= StageBeg && Target < StageEnd) { CheckJump(Addr, Target); return; }
+   if (Set->FixN >= Set->FixMax) Set->Fixes = (RelFix *)GrowArray(Set->Fixes, Set->FixMax, sizeof *Set->Fixes);
+   RelFix *Fix = &Set->Fixes[Set->FixN++]; Fix->Addr = Addr, Fix->Target = Target;
+}
+
+// The section staged at Addr, or -1 for an address of the fixed code.
+static int FindSection(uint32_t Addr) {
+   SectionSetP Set = Sections;
+   if (Addr < StageBeg) return -1;
+// The sections are staged in ascending order, each with a spare byte after it.
+   int Lo = 0, Hi = Set->SectN;
+   while (Hi - Lo > 1) {
+      int Mid = (Lo + Hi)/2;
+      if (Set->Sects[Mid].Stage <= Addr) Lo = Mid; else Hi = Mid;
+   }
+   return Set->SectN > 0 && Addr >= Set->Sects[Lo].Stage && Addr <= Set->Sects[Lo].Stage + Set->Sects[Lo].Size? Lo: -1;
+}
+
+// The copy of Sym for variant V, or nullptr, if that variant never used it.
+static SymbolP VarCopy(SymbolP Sym, int V) { return V == 0? Sym: Sym->Var == nullptr? nullptr: &Sym->Var[V - 1]; }
+
+// A reference from a section (or from the fixed code: -1) to a section.
+struct SectRef { int From, To; };
+
+// Find the sections in use: those referenced by the fixed code, and, in turn, by the sections in use.
+static void FindLive(int V) {
+   SectionSetP Set = Sections;
+   SectRef *Refs = nullptr; int RefN = 0, RefMax = 0;
+   for (int S = 0; S < Set->SectN; S++) Set->Sects[S].Live = false;
+   for (int H = 0; H < 0x100; H++) for (SymbolP Sym0 = SymTab[H]; Sym0 != nullptr; Sym0 = Sym0->Next) {
+      SymbolP Sym = VarCopy(Sym0, V); if (Sym == nullptr) continue;
+   // An expression is only on the list of its first undefined symbol, so look at all of its symbols.
+      for (PatchListP Patch = Sym->Patch; Patch != nullptr; Patch = Patch->Next)
+         for (CommandP Cmd = Patch->Cmd; Cmd->Type != BadL; Cmd++) {
+            if (Cmd->Type != SymL || !((SymbolP)Cmd->Value)->Deferred) continue;
+            int From = FindSection(Patch->Addr), To = FindSection(((SymbolP)Cmd->Value)->Value);
+            if (To < 0 || From == To) continue;
+            if (From < 0) { Set->Sects[To].Live = true; continue; }
+            if (RefN >= RefMax) Refs = (SectRef *)GrowArray(Refs, RefMax, sizeof *Refs);
+            Refs[RefN].From = From, Refs[RefN].To = To, RefN++;
+         }
+   }
+   for (bool More = true; More; ) {
+      More = false;
+      for (int R = 0; R < RefN; R++)
+         if (Set->Sects[Refs[R].From].Live && !Set->Sects[Refs[R].To].Live) Set->Sects[Refs[R].To].Live = More = true;
+   }
+   free(Refs);
+}
+
+// A free range of the address space: Lo⋯Hi-1.
+struct Gap { uint32_t Lo, Hi; };
+
+// Largest first; in the order of the source, otherwise.
+static int CompareSize(const void *A, const void *B) {
+   const Section *SA = *(const Section *const *)A, *SB = *(const Section *const *)B;
+   if (SA->Size != SB->Size) return SA->Size > SB->Size? -1: +1;
+   return SA->Stage < SB->Stage? -1: +1;
+}
+
+int PlaceSections(int V, bool Prune, uint32_t LoPC, uint32_t HiPC) {
+   SectionSetP Set = Sections;
+   if (Set->Cur >= 0) { fprintf(ListF, "----    SECTION without ENDS\n"); return 1; }
+   if (Set->SectN == 0) return 0;
+   Section *Sects = Set->Sects; int SectN = Set->SectN, ErrN = 0;
+   if (Prune) FindLive(V);
+// The gaps: the free ranges between the fixed code, then the range after it.
+   Gap *Gaps = (Gap *)malloc((StageBeg/2 + 1)*sizeof *Gaps); if (Gaps == nullptr) exit(1);
+   int GapN = 0;
+   for (uint32_t PC = LoPC <= HiPC? LoPC: 0; PC < StageBeg; ) {
+      if (IsUsed(PC)) { PC++; continue; }
+      Gaps[GapN].Lo = PC;
+      while (PC < StageBeg && !IsUsed(PC)) PC++;
+      Gaps[GapN++].Hi = PC;
+   }
+// First fit, in the order of decreasing size.
+   Section **Order = (Section **)malloc(SectN*sizeof *Order); if (Order == nullptr) exit(1);
+   for (int S = 0; S < SectN; S++) Order[S] = &Sects[S];
+   qsort(Order, SectN, sizeof *Order, CompareSize);
+   uint32_t GapBytes = 0, EndBytes = 0, DeadBytes = 0;
+   for (int O = 0; O < SectN; O++) {
+      Section *Sect = Order[O];
+      if (!Sect->Live) { DeadBytes += Sect->Size; continue; }
+      int G = 0; while (G < GapN && Gaps[G].Hi - Gaps[G].Lo < Sect->Size) G++;
+      if (G == GapN) { ErrN++; continue; }
+      Sect->Base = Gaps[G].Lo, Gaps[G].Lo += Sect->Size, Sect->Placed = true;
+      if (Sect->Size == 0) continue;
+      if (Sect->Base + Sect->Size - 1 <= HiPC) GapBytes += Sect->Size; else EndBytes += Sect->Size;
+      memcpy(RAM + Sect->Base, RAM + Sect->Stage, Sect->Size), CheckPC(Sect->Base), CheckPC(Sect->Base + Sect->Size - 1);
+   }
+   free(Order), free(Gaps);
+// Move the patches into the sections placed and drop those into the sections removed.
+   for (int H = 0; H < 0x100; H++) for (SymbolP Sym0 = SymTab[H]; Sym0 != nullptr; Sym0 = Sym0->Next) {
+      SymbolP Sym = VarCopy(Sym0, V); if (Sym == nullptr) continue;
+      for (PatchListP *PatchP = &Sym->Patch, Patch; (Patch = *PatchP) != nullptr; ) {
+         int S = FindSection(Patch->Addr);
+         if (S < 0 || Sects[S].Placed) {
+            if (S >= 0) Patch->Addr += Sects[S].Base - Sects[S].Stage;
+            PatchP = &Patch->Next;
+         } else *PatchP = Patch->Next, free(Patch->Cmd), free(Patch);
+      }
+   }
+   for (int F = 0; F < Set->FixN; F++) {
+      RelFix *Fix = &Set->Fixes[F]; int S = FindSection(Fix->Addr);
+      if (S < 0 || !Sects[S].Placed) continue;
+      Fix->Addr += Sects[S].Base - Sects[S].Stage, CheckJump(Fix->Addr, Fix->Target), RAM[Fix->Addr] = Fix->Target - (Fix->Addr + 1);
+   }
+// The name of a section is that of its first label.
+   const char **Names = (const char **)calloc(SectN, sizeof *Names); if (Names == nullptr) exit(1);
+   for (int L = 0; L < Set->LabelN; L++) {
+      SymbolP Sym = Set->Labels[L]; int S = FindSection(Sym->Value);
+      if (Names[S] == nullptr) Names[S] = Sym->Name;
+      if (!Sects[S].Placed) continue;
+      Sym->Value += Sects[S].Base - Sects[S].Stage, Sym->Defined = true, Sym->Deferred = false;
+      ResolvePatches(Sym);
+   }
+// The map.
+   if (VarN > 1) fprintf(ListF, "\nSection placement (variant %d):\n", V + 1); else fprintf(ListF, "\nSection placement:\n");
+   for (int S = 0; S < SectN; S++) {
+      const Section *Sect = &Sects[S];
+      char Name[0x10]; if (Names[S] == nullptr) snprintf(Name, sizeof Name, "#%d", S + 1);
+      const char *SectName = Names[S] != nullptr? Names[S]: Name;
+      if (Sect->Placed) fprintf(ListF, "%04X-%04X %6u bytes  %s\n", Sect->Base, Sect->Base + Sect->Size - (Sect->Size > 0), Sect->Size, SectName);
+      else if (Sect->Live) fprintf(ListF, "----      %6u bytes  %s: no room!\n", Sect->Size, SectName);
+      else fprintf(ListF, "----      %6u bytes  %s removed\n", Sect->Size, SectName);
+   }
+   fprintf(ListF, "%u bytes placed into gaps, %u bytes after the fixed code, %u bytes removed\n", GapBytes, EndBytes, DeadBytes);
+   free(Names);
+   return ErrN;
+}
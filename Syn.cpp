@@ -257,11 +257,13 @@ static void DoOpcode(CommandP &Cmd) {
                   *RamP++ = Op0a | (LexN(Op1) << 3);
                // Expression undefined: add a PC-relative byte and end processing.
                   if (Patch2 != nullptr) Patch2->Type = 2, Patch2->Addr = RamP - RAM, Patch2 = nullptr;
+                  else NoteJump(RamP - RAM, Value2);
                   *RamP = uint8_t(Value2 - (RamP - RAM) - 1), RamP++;
                } else if (Op1 == _Dw && Op2 == 0) { // jr Aw
                   *RamP++ = Op0b;
                // Expression undefined: add a PC-relative byte and end processing.
                   if (Patch1 != nullptr) Patch1->Type = 2, Patch1->Addr = RamP - RAM, Patch1 = nullptr;
+                  else NoteJump(RamP - RAM, Value1);
                   *RamP = uint8_t(Value1 - (RamP - RAM) - 1), RamP++;
                } else Error("Condition not allowed");
             break;
@@ -318,6 +320,7 @@ static void DoOpcode(CommandP &Cmd) {
          *RamP++ = Op0a;
       // Expression undefined: add a PC-relative byte and end processing.
          if (Patch1 != nullptr) Patch1->Type = 2, Patch1->Addr = RamP - RAM, Patch1 = nullptr;
+         else NoteJump(RamP - RAM, Value1);
          *RamP = uint8_t(Value1 - (RamP - RAM) - 1), RamP++; // Relocate.
       break;
    // ex (SP),Rw; ex DE,HL; ex AF,AF'.
@@ -525,16 +528,18 @@ static void DoOpcode(CommandP &Cmd) {
          Error("unknown opcode type");
          for (; Cmd->Type != 0; Cmd++);
    }
+   MarkUsed(CurPC, RamP - RAM);
    CurPC = RamP - RAM; // PC -> next opcode
    CheckPC(CurPC - 1); // The last RAM position used>
 }
 
 // Test for pseudo-opcodes.
-static bool PassOver = false; // Ignore all lines till next "ENDIF" (this could be a stack for nesting support).
+bool PassOver = false; // Ignore all lines till next "ENDIF" (this could be a stack for nesting support).
 
 static void DoPseudo(CommandP &Cmd) {
-   uint16_t PC = CurPC;
-   switch (Cmd++->Value) { // All pseudo-opcodes
+   uint32_t PC = CurPC;
+   uint16_t Op = Cmd++->Value;
+   switch (Op) { // All pseudo-opcodes
       case _db: case _dm:
          Cmd--;
          do {
@@ -583,9 +588,13 @@ static void DoPseudo(CommandP &Cmd) {
       break;
    // Set the PC.
       case _org:
+         if (Sections->Cur >= 0) Error("ORG inside a section");
          PC = GetExp(Cmd);
          if (LastPatch != nullptr) Error("symbol not defined");
       break;
+   // Start or end a relocatable section.
+      case _section: CurPC = PC, BegSection(), PC = CurPC; break;
+      case _ends: CurPC = PC, EndSection(), PC = CurPC; break;
    // IF condition false: then ignore the next block.
       case _if:
          if (GetExp(Cmd) == 0) PassOver = true;
@@ -596,19 +605,46 @@ static void DoPseudo(CommandP &Cmd) {
       case _else: PassOver = !PassOver; break;
       case _print:
          if (Cmd->Type != StrL) Error("PRINT requires a string parameter");
-         else puts((char *)Cmd++->Value); // Print a message.
+         else fprintf(ListF, "%s\n", (char *)Cmd++->Value); // Print a message.
       break;
    }
+// Data and space reserved by the fixed code.
+   if (Op != _org && Op != _section && Op != _ends) MarkUsed(CurPC, PC);
    CurPC = PC;
 }
 
+// Back-patch the expressions that depend on a newly defined symbol.
+void ResolvePatches(SymbolP Sym) {
+   while (Sym->Patch != nullptr) { // Do expressions depend on the symbol?
+      PatchListP Patch = Sym->Patch;
+      Sym->Patch = Patch->Next; // To the next symbol.
+      CommandP Cmd0 = Patch->Cmd;
+      int32_t Value = GetExp(Patch->Cmd); // Recalculate the symbol (now with the defined symbol)
+      if (LastPatch == nullptr) { // Is the expression now valid? (or is there another open dependency?)
+         uint32_t Addr = Patch->Addr;
+         switch (Patch->Type) {
+         // Add a single byte.
+            case 0: List("%04X <- %02X\n", Addr, Value), RAM[Addr] = Value; break;
+         // Add two bytes.
+            case 1: List("%04X <- %02X %02X\n", Addr, Value&0xff, Value >> 8), RAM[Addr++] = Value, RAM[Addr] = Value >> 8; break;
+         // Add a PC-relative byte.
+            case 2: NoteJump(Addr, Value), Value -= Addr + 1, List("%04X <- %02X\n", Addr, Value), RAM[Addr] = Value; break;
+            default: Error("unknown Patch type");
+         }
+      } else // The expression still can't be calculated: transfer the type and the address.
+         LastPatch->Type = Patch->Type, LastPatch->Addr = Patch->Addr, KeepLastPatch();
+      free(Cmd0); // Release the formula.
+      free(Patch); // Release the Patch term.
+   }
+}
+
 // Compile a line into machine code.
 void CompileLine(void) {
    CommandP Cmd = CmdBuf;
    if (Cmd->Type == 0) return; // Empty line => done.
    if (Cmd->Type == SymL && !PassOver) { // The symbol is at the beginning, but not IF?
       SymbolP Sym = (SymbolP)Cmd->Value; // Dereference the symbol.
-      if (Sym->Defined) Error("symbol already defined");
+      if (Sym->Defined || Sym->Deferred) Error("symbol already defined");
       Cmd++; // The next command.
       if (Cmd->Type == OpL && Cmd->Value == ':') Cmd++; // Ignore a ":" after a symbol.
       if (Cmd->Type == OpL && Cmd->Value == _equ) { // EQU?
@@ -617,29 +653,13 @@ void CompileLine(void) {
          if (LastPatch != nullptr) Error("symbol not defined in a formula");
          Sym->Defined = true; // The symbol is now defined.
          if (Cmd->Type != BadL) Error("EQU is followed by illegal data");
-      } else Sym->Value = CurPC, Sym->Defined = true; // The symbol is an address defined as the current PC.
-      while (Sym->Patch != nullptr) { // Do expressions depend on the symbol?
-         PatchListP Patch = Sym->Patch;
-         Sym->Patch = Patch->Next; // To the next symbol.
-         CommandP Cmd0 = Patch->Cmd;
-         int32_t Value = GetExp(Patch->Cmd); // Recalculate the symbol (now with the defined symbol)
-         if (LastPatch == nullptr) { // Is the expression now valid? (or is there another open dependency?)
-            uint16_t Addr = Patch->Addr;
-            switch (Patch->Type) {
-            // Add a single byte.
-               case 0: List("%04X <- %02X\n", Addr, Value), RAM[Addr] = Value; break;
-            // Add two bytes.
-               case 1: List("%04X <- %02X %02X\n", Addr, Value&0xff, Value >> 8), RAM[Addr++] = Value, RAM[Addr] = Value >> 8; break;
-            // Add a PC-relative byte.
-               case 2: Value -= Addr + 1, List("%04X <- %02X\n", Addr, Value), RAM[Addr] = Value; break;
-               default: Error("unknown Patch type");
-            }
-         } else // The expression still can't be calculated: transfer the type and the address.
-            LastPatch->Type = Patch->Type, LastPatch->Addr = Patch->Addr;
-         free(Cmd0); // Release the formula.
-         free(Patch); // Release the Patch term.
-      }
+   // A section label stays undefined until its section is placed.
+      } else if (Sections->Cur >= 0 || Cmd->Type == OpL && Cmd->Value == _section) DeferLabel(Sym);
+      else Sym->Value = CurPC, Sym->Defined = true; // The symbol is an address defined as the current PC.
+      if (Sym->Defined) ResolvePatches(Sym);
    }
+// "$" is the staging address inside a section, which does not survive the placement.
+   if (!PassOver && Sections->Cur >= 0 && PCRefN > 0) Error("$ inside a section");
    if (PassOver) { // Inside an IF?
       if (Cmd->Type == OpL) switch (Cmd->Value) {
       // ENDIF reached: start compiling.
@@ -0,0 +1,8 @@
+; Error recovery: each error abandons the rest of its line, and the assembly resumes with the next one.
+	JP	FOO		; FOO is never defined, and is reported at the end.
+	.BAR	NOP		; An error in the tokenizer.
+	JP	BAZ,1		; An error after a forward reference, which is dropped with its line.
+	LD	(BAZ),Q		; The same, for the 2nd operand.
+	LD	Q,1		; An error in the encoder.
+BAZ:	NOP
+	END